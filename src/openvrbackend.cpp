@@ -0,0 +1,278 @@
+/*
+ * openvrbackend.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrbackend.h"
+#include "openvrcachefile.h"
+
+#include <osg/Notify>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <algorithm>
+
+OpenVRRuntimeBackend::OpenVRRuntimeBackend() :
+    m_trackingSpace(vr::TrackingUniverseSeated),
+    m_vrSystem(nullptr),
+    m_vrCompositor(nullptr),
+    m_vrRenderModels(nullptr)
+{
+    // Loading the SteamVR Runtime
+    vr::EVRInitError eError = vr::VRInitError_None;
+    m_vrSystem = vr::VR_Init(&eError, vr::VRApplication_Scene);
+
+    if (eError != vr::VRInitError_None)
+    {
+        m_vrSystem = nullptr;
+        osg::notify(osg::WARN)
+            << "Error: Unable to initialize the OpenVR library.\n"
+            << "Reason: " << vr::VR_GetVRInitErrorAsEnglishDescription( eError ) << std::endl;
+        return;
+    }
+
+    m_vrCompositor = vr::VRCompositor();
+    if ( !m_vrCompositor )
+    {
+        m_vrSystem = nullptr;
+        vr::VR_Shutdown();
+        osg::notify(osg::WARN) << "Error: Compositor initialization failed" << std::endl;
+        return;
+    }
+
+    m_vrRenderModels = (vr::IVRRenderModels *)vr::VR_GetGenericInterface(vr::IVRRenderModels_Version, &eError);
+    if (m_vrRenderModels == nullptr)
+    {
+        m_vrSystem = nullptr;
+        m_vrCompositor = nullptr;
+        vr::VR_Shutdown();
+        osg::notify(osg::WARN)
+            << "Error: Unable to get render model interface!\n"
+            << "Reason: " << vr::VR_GetVRInitErrorAsEnglishDescription( eError ) << std::endl;
+        return;
+    }
+}
+
+OpenVRRuntimeBackend::~OpenVRRuntimeBackend()
+{
+    shutdown();
+}
+
+bool OpenVRRuntimeBackend::initialized() const
+{
+    return m_vrSystem != nullptr && m_vrCompositor != nullptr && m_vrRenderModels != nullptr;
+}
+
+void OpenVRRuntimeBackend::shutdown()
+{
+    if (m_vrSystem != nullptr)
+    {
+        vr::VR_Shutdown();
+        m_vrSystem = nullptr;
+        m_vrCompositor = nullptr;
+        m_vrRenderModels = nullptr;
+    }
+}
+
+std::string OpenVRRuntimeBackend::trackedDeviceProperty(vr::TrackedDeviceIndex_t index, vr::TrackedDeviceProperty prop)
+{
+    uint32_t bufferLen = m_vrSystem->GetStringTrackedDeviceProperty(index, prop, NULL, 0);
+    if (bufferLen == 0)
+    {
+        return "";
+    }
+
+    char* buffer = new char[bufferLen];
+    bufferLen = m_vrSystem->GetStringTrackedDeviceProperty(index, prop, buffer, bufferLen);
+    std::string result = buffer;
+    delete [] buffer;
+    return result;
+}
+
+float OpenVRRuntimeBackend::displayFrequency()
+{
+    return m_vrSystem->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+}
+
+void OpenVRRuntimeBackend::recommendedRenderTargetSize(uint32_t& width, uint32_t& height)
+{
+    m_vrSystem->GetRecommendedRenderTargetSize(&width, &height);
+}
+
+vr::HmdMatrix44_t OpenVRRuntimeBackend::projectionMatrix(vr::EVREye eye, float nearClip, float farClip)
+{
+    return m_vrSystem->GetProjectionMatrix(eye, nearClip, farClip);
+}
+
+vr::HmdMatrix34_t OpenVRRuntimeBackend::eyeToHeadTransform(vr::EVREye eye)
+{
+    return m_vrSystem->GetEyeToHeadTransform(eye);
+}
+
+void OpenVRRuntimeBackend::resetSeatedZeroPose()
+{
+    m_vrSystem->ResetSeatedZeroPose();
+}
+
+vr::HiddenAreaMesh_t OpenVRRuntimeBackend::hiddenAreaMesh(vr::EVREye eye)
+{
+    return m_vrSystem->GetHiddenAreaMesh(eye);
+}
+
+bool OpenVRRuntimeBackend::isTrackedDeviceConnected(vr::TrackedDeviceIndex_t index)
+{
+    return m_vrSystem->IsTrackedDeviceConnected(index);
+}
+
+vr::ETrackedDeviceClass OpenVRRuntimeBackend::trackedDeviceClass(vr::TrackedDeviceIndex_t index)
+{
+    return m_vrSystem->GetTrackedDeviceClass(index);
+}
+
+vr::ETrackedControllerRole OpenVRRuntimeBackend::controllerRole(vr::TrackedDeviceIndex_t index)
+{
+    return m_vrSystem->GetControllerRoleForTrackedDeviceIndex(index);
+}
+
+bool OpenVRRuntimeBackend::controllerState(vr::TrackedDeviceIndex_t index, vr::VRControllerState_t& state)
+{
+    return m_vrSystem->GetControllerState(index, &state, sizeof(state));
+}
+
+bool OpenVRRuntimeBackend::pollNextEvent(vr::VREvent_t& event)
+{
+    return m_vrSystem->PollNextEvent(&event, sizeof(event));
+}
+
+void OpenVRRuntimeBackend::setTrackingSpace(vr::ETrackingUniverseOrigin origin)
+{
+    m_trackingSpace = origin;
+    m_vrCompositor->SetTrackingSpace(origin);
+}
+
+bool OpenVRRuntimeBackend::waitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count)
+{
+    return m_vrCompositor->WaitGetPoses(poses, count, NULL, 0) == vr::VRCompositorError_None;
+}
+
+bool OpenVRRuntimeBackend::submit(vr::EVREye eye, const vr::Texture_t& texture, const vr::VRTextureBounds_t* bounds)
+{
+    return m_vrCompositor->Submit(eye, &texture, bounds) == vr::VRCompositorError_None;
+}
+
+bool OpenVRRuntimeBackend::frameTiming(vr::Compositor_FrameTiming& timing, uint32_t framesAgo)
+{
+    timing.m_nSize = sizeof(vr::Compositor_FrameTiming);
+    return m_vrCompositor->GetFrameTiming(&timing, framesAgo);
+}
+
+bool OpenVRRuntimeBackend::devicePoses(vr::TrackedDevicePose_t* poses, uint32_t count, float secondsFromNow)
+{
+    m_vrSystem->GetDeviceToAbsoluteTrackingPose(m_trackingSpace, secondsFromNow, poses, count);
+    return true;
+}
+
+float OpenVRRuntimeBackend::secondsToPhotons()
+{
+    // As recommended by the OpenVR documentation of GetDeviceToAbsoluteTrackingPose().
+    float secondsSinceLastVsync = 0.0f;
+    m_vrSystem->GetTimeSinceLastVsync(&secondsSinceLastVsync, nullptr);
+    const float frameDuration = 1.0f / displayFrequency();
+    const float vsyncToPhotons = m_vrSystem->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SecondsFromVsyncToPhotons_Float);
+    return frameDuration - secondsSinceLastVsync + vsyncToPhotons;
+}
+
+bool OpenVRRuntimeBackend::mirrorTexture(vr::EVREye eye, vr::glUInt_t& texture, vr::glSharedTextureHandle_t& handle)
+{
+    return m_vrCompositor->GetMirrorTextureGL(eye, &texture, &handle) == vr::VRCompositorError_None;
+}
+
+void OpenVRRuntimeBackend::releaseMirrorTexture(vr::glUInt_t texture, vr::glSharedTextureHandle_t handle)
+{
+    m_vrCompositor->ReleaseSharedGLTexture(texture, handle);
+}
+
+void OpenVRRuntimeBackend::lockMirrorTexture(vr::glSharedTextureHandle_t handle)
+{
+    m_vrCompositor->LockGLSharedTextureForAccess(handle);
+}
+
+void OpenVRRuntimeBackend::unlockMirrorTexture(vr::glSharedTextureHandle_t handle)
+{
+    m_vrCompositor->UnlockGLSharedTextureForAccess(handle);
+}
+
+vr::EVRRenderModelError OpenVRRuntimeBackend::loadRenderModel(const std::string& name, vr::RenderModel_t** model)
+{
+    return m_vrRenderModels->LoadRenderModel_Async(name.c_str(), model);
+}
+
+void OpenVRRuntimeBackend::freeRenderModel(vr::RenderModel_t* model)
+{
+    m_vrRenderModels->FreeRenderModel(model);
+}
+
+vr::EVRRenderModelError OpenVRRuntimeBackend::loadRenderModelTexture(vr::TextureID_t id, vr::RenderModel_TextureMap_t** texture)
+{
+    return m_vrRenderModels->LoadTexture_Async(id, texture);
+}
+
+void OpenVRRuntimeBackend::freeRenderModelTexture(vr::RenderModel_TextureMap_t* texture)
+{
+    m_vrRenderModels->FreeTexture(texture);
+}
+
+std::string OpenVRRuntimeBackend::renderModelVersion(const std::string& name)
+{
+    // The runtime reads the model from this file, it is replaced when SteamVR updates the model.
+    vr::EVRRenderModelError error = vr::VRRenderModelError_None;
+    uint32_t bufferLen = m_vrRenderModels->GetRenderModelOriginalPath(name.c_str(), NULL, 0, &error);
+    if (bufferLen == 0)
+    {
+        return "";
+    }
+
+    char* buffer = new char[bufferLen];
+    bufferLen = m_vrRenderModels->GetRenderModelOriginalPath(name.c_str(), buffer, bufferLen, &error);
+    const std::string path = (error == vr::VRRenderModelError_None) ? buffer : "";
+    delete [] buffer;
+
+    if (path.empty())
+    {
+        return "";
+    }
+
+    // The diffuse texture is baked into the cached model. Its file is not reported, but the
+    // runtime keeps it next to the model, so every file of the model's directory is hashed.
+    const std::string directory = osgDB::getFilePath(path);
+    osgDB::DirectoryContents files;
+    if (directory.empty())
+    {
+        files.push_back(path);
+    }
+    else
+    {
+        const osgDB::DirectoryContents contents = osgDB::getDirectoryContents(directory);
+        for (const std::string& file : contents)
+        {
+            const std::string filePath = directory + "/" + file;
+            if (osgDB::fileType(filePath) == osgDB::REGULAR_FILE)
+            {
+                files.push_back(filePath);
+            }
+        }
+        std::sort(files.begin(), files.end());
+    }
+
+    uint64_t hash = OpenVRCacheFile::HASH_SEED;
+    for (const std::string& file : files)
+    {
+        uint64_t fileHash;
+        if (!OpenVRCacheFile::hashFile(file, fileHash))
+        {
+            return "";
+        }
+        hash = OpenVRCacheFile::hashString(osgDB::getSimpleFileName(file) + OpenVRCacheFile::hexString(fileHash), hash);
+    }
+    return OpenVRCacheFile::hexString(hash);
+}
@@ -0,0 +1,125 @@
+/*
+ * openvrbackend.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRBACKEND_H_
+#define _OSG_OPENVRBACKEND_H_
+
+// Include the OpenVR SDK
+#include <openvr.h>
+
+#include <osg/Referenced>
+#include <string>
+
+// Tracking and compositor services used by OpenVRDevice. The runtime backend
+// forwards to IVRSystem/IVRCompositor, other backends (e.g. a simulated HMD)
+// can stand in for the runtime when no headset is available.
+class OpenVRBackend : public osg::Referenced
+{
+public:
+    virtual bool initialized() const = 0;
+    virtual void shutdown() = 0;
+
+    virtual std::string trackedDeviceProperty(vr::TrackedDeviceIndex_t index, vr::TrackedDeviceProperty prop) = 0;
+    virtual float displayFrequency() = 0;
+
+    virtual void recommendedRenderTargetSize(uint32_t& width, uint32_t& height) = 0;
+    virtual vr::HmdMatrix44_t projectionMatrix(vr::EVREye eye, float nearClip, float farClip) = 0;
+    virtual vr::HmdMatrix34_t eyeToHeadTransform(vr::EVREye eye) = 0;
+    virtual void resetSeatedZeroPose() = 0;
+    // Triangles covering the pixels of the eye's render target that cannot be seen through the lens.
+    virtual vr::HiddenAreaMesh_t hiddenAreaMesh(vr::EVREye eye) = 0;
+
+    virtual bool isTrackedDeviceConnected(vr::TrackedDeviceIndex_t index) = 0;
+    virtual vr::ETrackedDeviceClass trackedDeviceClass(vr::TrackedDeviceIndex_t index) = 0;
+    virtual vr::ETrackedControllerRole controllerRole(vr::TrackedDeviceIndex_t index) = 0;
+    virtual bool controllerState(vr::TrackedDeviceIndex_t index, vr::VRControllerState_t& state) = 0;
+    virtual bool pollNextEvent(vr::VREvent_t& event) = 0;
+
+    virtual void setTrackingSpace(vr::ETrackingUniverseOrigin origin) = 0;
+    virtual bool waitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count) = 0;
+    virtual bool submit(vr::EVREye eye, const vr::Texture_t& texture, const vr::VRTextureBounds_t* bounds = nullptr) = 0;
+    virtual bool frameTiming(vr::Compositor_FrameTiming& timing, uint32_t framesAgo = 0) = 0;
+
+    // Poses extrapolated from the latest tracking data to secondsFromNow, without waiting for vsync.
+    // Negative values look back, e.g. to the time a frame was displayed.
+    virtual bool devicePoses(vr::TrackedDevicePose_t* poses, uint32_t count, float secondsFromNow) = 0;
+    // Estimated time until a frame started now is lit on the display.
+    virtual float secondsToPhotons() = 0;
+
+    // GL texture showing what the compositor displays for the eye, shared with the current context.
+    // Returns false when the backend has no compositor output. Access must be locked while reading it.
+    virtual bool mirrorTexture(vr::EVREye eye, vr::glUInt_t& texture, vr::glSharedTextureHandle_t& handle) = 0;
+    virtual void releaseMirrorTexture(vr::glUInt_t texture, vr::glSharedTextureHandle_t handle) = 0;
+    virtual void lockMirrorTexture(vr::glSharedTextureHandle_t handle) = 0;
+    virtual void unlockMirrorTexture(vr::glSharedTextureHandle_t handle) = 0;
+
+    // Render models of tracked devices and their diffuse textures. Loading is asynchronous:
+    // VRRenderModelError_Loading is returned until the data is available, then it must be freed.
+    virtual vr::EVRRenderModelError loadRenderModel(const std::string& name, vr::RenderModel_t** model) = 0;
+    virtual void freeRenderModel(vr::RenderModel_t* model) = 0;
+    virtual vr::EVRRenderModelError loadRenderModelTexture(vr::TextureID_t id, vr::RenderModel_TextureMap_t** texture) = 0;
+    virtual void freeRenderModelTexture(vr::RenderModel_TextureMap_t* texture) = 0;
+    // Changes whenever the data of the render model or its texture changes, e.g. when the runtime is updated.
+    // Empty when it cannot be determined, the model must not be cached then.
+    virtual std::string renderModelVersion(const std::string& name) = 0;
+
+protected:
+    virtual ~OpenVRBackend() {}
+};
+
+// Backend talking to the installed OpenVR/SteamVR runtime.
+class OpenVRRuntimeBackend : public OpenVRBackend
+{
+public:
+    OpenVRRuntimeBackend();
+
+    virtual bool initialized() const;
+    virtual void shutdown();
+
+    virtual std::string trackedDeviceProperty(vr::TrackedDeviceIndex_t index, vr::TrackedDeviceProperty prop);
+    virtual float displayFrequency();
+
+    virtual void recommendedRenderTargetSize(uint32_t& width, uint32_t& height);
+    virtual vr::HmdMatrix44_t projectionMatrix(vr::EVREye eye, float nearClip, float farClip);
+    virtual vr::HmdMatrix34_t eyeToHeadTransform(vr::EVREye eye);
+    virtual void resetSeatedZeroPose();
+    virtual vr::HiddenAreaMesh_t hiddenAreaMesh(vr::EVREye eye);
+
+    virtual bool isTrackedDeviceConnected(vr::TrackedDeviceIndex_t index);
+    virtual vr::ETrackedDeviceClass trackedDeviceClass(vr::TrackedDeviceIndex_t index);
+    virtual vr::ETrackedControllerRole controllerRole(vr::TrackedDeviceIndex_t index);
+    virtual bool controllerState(vr::TrackedDeviceIndex_t index, vr::VRControllerState_t& state);
+    virtual bool pollNextEvent(vr::VREvent_t& event);
+
+    virtual void setTrackingSpace(vr::ETrackingUniverseOrigin origin);
+    virtual bool waitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count);
+    virtual bool submit(vr::EVREye eye, const vr::Texture_t& texture, const vr::VRTextureBounds_t* bounds = nullptr);
+    virtual bool frameTiming(vr::Compositor_FrameTiming& timing, uint32_t framesAgo = 0);
+
+    virtual bool devicePoses(vr::TrackedDevicePose_t* poses, uint32_t count, float secondsFromNow);
+    virtual float secondsToPhotons();
+
+    virtual bool mirrorTexture(vr::EVREye eye, vr::glUInt_t& texture, vr::glSharedTextureHandle_t& handle);
+    virtual void releaseMirrorTexture(vr::glUInt_t texture, vr::glSharedTextureHandle_t handle);
+    virtual void lockMirrorTexture(vr::glSharedTextureHandle_t handle);
+    virtual void unlockMirrorTexture(vr::glSharedTextureHandle_t handle);
+
+    virtual vr::EVRRenderModelError loadRenderModel(const std::string& name, vr::RenderModel_t** model);
+    virtual void freeRenderModel(vr::RenderModel_t* model);
+    virtual vr::EVRRenderModelError loadRenderModelTexture(vr::TextureID_t id, vr::RenderModel_TextureMap_t** texture);
+    virtual void freeRenderModelTexture(vr::RenderModel_TextureMap_t* texture);
+    virtual std::string renderModelVersion(const std::string& name);
+
+protected:
+    ~OpenVRRuntimeBackend();
+
+    vr::ETrackingUniverseOrigin m_trackingSpace; // of the compositor, devicePoses() uses the same
+    vr::IVRSystem* m_vrSystem;
+    vr::IVRCompositor* m_vrCompositor;
+    vr::IVRRenderModels* m_vrRenderModels;
+};
+
+#endif /* _OSG_OPENVRBACKEND_H_ */
@@ -0,0 +1,206 @@
+/*
+ * openvrcachefile.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrcachefile.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+    #include <sys/utime.h>
+#else
+    #include <utime.h>
+#endif
+
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/Options>
+#include <osgDB/WriteFile>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <vector>
+
+// Size of the blocks files are hashed in, a multiple of 8.
+static const size_t s_hashBlockSize = 1 << 20;
+static const uint64_t s_fnvPrime = 0x100000001b3ULL;
+// Temporary files unchanged for that long belong to a writer that did not finish.
+static const double s_staleTempSeconds = 3600.0;
+static const std::string s_tempSuffix = ".tmp.osgb";
+
+struct OpenVRCacheEntry
+{
+    std::string path;
+    uint64_t size;
+    time_t modified;
+};
+
+// Size and time of the last change of a file, false when it does not exist.
+static bool fileStatus(const std::string& path, uint64_t& size, time_t& modified)
+{
+#ifdef _WIN32
+    struct _stat64 status;
+    if (_stat64(path.c_str(), &status) != 0)
+#else
+    struct stat status;
+    if (stat(path.c_str(), &status) != 0)
+#endif
+    {
+        return false;
+    }
+    size = static_cast<uint64_t>(status.st_size);
+    modified = status.st_mtime;
+    return true;
+}
+
+/* Public functions */
+bool OpenVRCacheFile::hashFile(const std::string& path, uint64_t& hash)
+{
+    std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+
+    // Eight bytes per multiply, so hashing stays well below the cost of parsing the file.
+    std::vector<char> block(s_hashBlockSize);
+    uint64_t size = 0;
+    hash = HASH_SEED;
+    while (file)
+    {
+        file.read(block.data(), block.size());
+        const size_t count = static_cast<size_t>(file.gcount());
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, block.data() + i, 8);
+            hash ^= word * 0x9e3779b97f4a7c15ULL;
+            hash = ((hash << 31) | (hash >> 33)) * 0xc2b2ae3d27d4eb4fULL;
+        }
+        for (; i < count; ++i)
+        {
+            hash = (hash ^ static_cast<unsigned char>(block[i])) * s_fnvPrime;
+        }
+        size += count;
+    }
+    if (file.bad())
+    {
+        return false;
+    }
+
+    // Final mix, so every input bit affects every output bit.
+    hash ^= size;
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return true;
+}
+
+uint64_t OpenVRCacheFile::hashString(const std::string& text, uint64_t hash)
+{
+    for (char c : text)
+    {
+        hash = (hash ^ static_cast<unsigned char>(c)) * s_fnvPrime;
+    }
+    return hash;
+}
+
+std::string OpenVRCacheFile::hexString(uint64_t value)
+{
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+bool OpenVRCacheFile::writeNode(const osg::Node& node, const std::string& fileName)
+{
+    // Unique among threads and processes writing the same entry at the same time.
+    const uint64_t writer = reinterpret_cast<uintptr_t>(&node) ^ static_cast<uint64_t>(osg::Timer::instance()->tick());
+    const std::string tempFile = osgDB::getNameLessExtension(fileName) + "." + hexString(writer) + s_tempSuffix;
+
+    // The images are stored in the file, the cache does not depend on image plugins.
+    osg::ref_ptr<osgDB::Options> options = new osgDB::Options("WriteImageHint=IncludeData");
+    if (!osgDB::writeNodeFile(node, tempFile, options.get()))
+    {
+        osg::notify(osg::WARN) << "Warning: Could not write cache file " << tempFile << std::endl;
+        std::remove(tempFile.c_str());
+        return false;
+    }
+
+    // Renaming onto an existing file fails on Windows, another thread may have written the same entry.
+    if (std::rename(tempFile.c_str(), fileName.c_str()) != 0)
+    {
+        std::remove(fileName.c_str());
+        if (std::rename(tempFile.c_str(), fileName.c_str()) != 0)
+        {
+            osg::notify(osg::WARN) << "Warning: Could not write cache file " << fileName << std::endl;
+            std::remove(tempFile.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OpenVRCacheFile::touch(const std::string& fileName)
+{
+#ifdef _WIN32
+    return _utime(fileName.c_str(), nullptr) == 0;
+#else
+    return utime(fileName.c_str(), nullptr) == 0;
+#endif
+}
+
+void OpenVRCacheFile::evict(const std::string& directory, uint64_t maximumSize, const std::string& keep)
+{
+    const time_t now = std::time(nullptr);
+    std::vector<OpenVRCacheEntry> entries;
+    uint64_t totalSize = 0;
+    const osgDB::DirectoryContents contents = osgDB::getDirectoryContents(directory);
+    for (const std::string& name : contents)
+    {
+        OpenVRCacheEntry entry;
+        entry.path = directory + "/" + name;
+        if (osgDB::getLowerCaseFileExtension(name) != "osgb" || !fileStatus(entry.path, entry.size, entry.modified))
+        {
+            continue;
+        }
+        if (name.size() > s_tempSuffix.size() && name.compare(name.size() - s_tempSuffix.size(), s_tempSuffix.size(), s_tempSuffix) == 0)
+        {
+            // Other threads or processes may still be writing theirs.
+            if (std::difftime(now, entry.modified) > s_staleTempSeconds)
+            {
+                std::remove(entry.path.c_str());
+            }
+            continue;
+        }
+        totalSize += entry.size;
+        if (entry.path != keep)
+        {
+            entries.push_back(entry);
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const OpenVRCacheEntry& a, const OpenVRCacheEntry& b) { return a.modified < b.modified; });
+    for (const OpenVRCacheEntry& entry : entries)
+    {
+        if (totalSize <= maximumSize)
+        {
+            break;
+        }
+        // An entry being read by another thread cannot be removed on Windows, it stays until the next eviction.
+        if (std::remove(entry.path.c_str()) == 0)
+        {
+            totalSize -= entry.size;
+        }
+    }
+}
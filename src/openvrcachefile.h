@@ -0,0 +1,40 @@
+/*
+ * openvrcachefile.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRCACHEFILE_H_
+#define _OSG_OPENVRCACHEFILE_H_
+
+#include <osg/Node>
+#include <stdint.h>
+#include <string>
+
+// Helpers of the disk caches for converted render models and scenes: content hashes for
+// the cache keys, writing entries so that no reader ever sees a half written file, and
+// keeping a cache directory below a size by removing the least recently used entries.
+class OpenVRCacheFile
+{
+public:
+    static const uint64_t HASH_SEED = 0xcbf29ce484222325ULL;
+
+    // Hash of the content of a file, false when it cannot be read.
+    static bool hashFile(const std::string& path, uint64_t& hash);
+    static uint64_t hashString(const std::string& text, uint64_t hash = HASH_SEED);
+    static std::string hexString(uint64_t value);
+
+    // Writes the node as .osgb with its images included, under a temporary name next to
+    // fileName that is then renamed. An existing entry is replaced.
+    static bool writeNode(const osg::Node& node, const std::string& fileName);
+
+    // Marks an entry as used now, eviction removes the entries unused for longest first.
+    static bool touch(const std::string& fileName);
+
+    // Removes the least recently used .osgb entries of the directory until together they take
+    // at most maximumSize bytes, never keep. Temporary files of writers that did not finish
+    // are removed as well.
+    static void evict(const std::string& directory, uint64_t maximumSize, const std::string& keep);
+};
+
+#endif /* _OSG_OPENVRCACHEFILE_H_ */
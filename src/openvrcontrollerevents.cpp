@@ -0,0 +1,66 @@
+/*
+ * openvrcontrollerevents.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrcontrollerevents.h"
+
+static unsigned int nextPowerOfTwo(unsigned int value)
+{
+    unsigned int result = 1;
+    while (result < value)
+    {
+        result <<= 1;
+    }
+    return result;
+}
+
+OpenVRControllerEvent::OpenVRControllerEvent() :
+    type(BUTTON_PRESS),
+    device(vr::k_unTrackedDeviceIndexInvalid),
+    role(vr::TrackedControllerRole_Invalid),
+    button(vr::k_EButton_System),
+    tick(0)
+{
+}
+
+OpenVRControllerEventQueue::OpenVRControllerEventQueue(unsigned int capacity) :
+    m_events(nextPowerOfTwo(capacity)),
+    m_mask(static_cast<unsigned int>(m_events.size()) - 1),
+    m_head(0),
+    m_tail(0)
+{
+}
+
+bool OpenVRControllerEventQueue::push(const OpenVRControllerEvent& event)
+{
+    // The indices run freely and wrap around, only their difference matters.
+    const unsigned int tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) > m_mask)
+    {
+        return false;
+    }
+
+    m_events[tail & m_mask] = event;
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+bool OpenVRControllerEventQueue::full() const
+{
+    return m_tail.load(std::memory_order_relaxed) - m_head.load(std::memory_order_acquire) > m_mask;
+}
+
+bool OpenVRControllerEventQueue::pop(OpenVRControllerEvent& event)
+{
+    const unsigned int head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    event = m_events[head & m_mask];
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,63 @@
+/*
+ * openvrcontrollerevents.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRCONTROLLEREVENTS_H_
+#define _OSG_OPENVRCONTROLLEREVENTS_H_
+
+#include <osg/Vec2f>
+#include <osg/Timer>
+#include <atomic>
+#include <vector>
+
+#include "openvrbackend.h"
+
+// A button of a tracked controller changed, with the controller's axes at that time.
+struct OpenVRControllerEvent
+{
+    enum Type
+    {
+        BUTTON_PRESS,
+        BUTTON_UNPRESS,
+        BUTTON_TOUCH,
+        BUTTON_UNTOUCH
+    };
+
+    OpenVRControllerEvent();
+
+    Type type;
+    vr::TrackedDeviceIndex_t device;
+    vr::ETrackedControllerRole role;
+    vr::EVRButtonId button;
+    osg::Vec2f axis[vr::k_unControllerStateAxisCount]; // touchpad, trigger, ...
+    osg::Timer_t tick; // when the runtime saw the event
+};
+
+// Bounded single producer, single consumer queue of controller events. The storage is
+// allocated once, pushing and popping only move the atomic head and tail indices, so one
+// thread can poll the runtime while another consumes the events without locks.
+class OpenVRControllerEventQueue
+{
+public:
+    // The capacity is rounded up to a power of two.
+    explicit OpenVRControllerEventQueue(unsigned int capacity = 256);
+
+    // Producer side. Returns false when the queue is full and the event was not added.
+    bool push(const OpenVRControllerEvent& event);
+    bool full() const;
+
+    // Consumer side. Returns false when there is no event.
+    bool pop(OpenVRControllerEvent& event);
+
+    unsigned int capacity() const { return m_mask + 1; }
+
+protected:
+    std::vector<OpenVRControllerEvent> m_events;
+    unsigned int m_mask;
+    std::atomic<unsigned int> m_head; // next event to pop, written by the consumer
+    std::atomic<unsigned int> m_tail; // next slot to push, written by the producer
+};
+
+#endif /* _OSG_OPENVRCONTROLLEREVENTS_H_ */
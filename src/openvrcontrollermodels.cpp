@@ -0,0 +1,166 @@
+/*
+ * openvrcontrollermodels.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrcontrollermodels.h"
+#include "openvrdevice.h"
+
+// Keeps the controllers in step with the device registry and the tracked poses.
+class OpenVRControllerModelsUpdateCallback : public osg::NodeCallback
+{
+public:
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        static_cast<OpenVRControllerModels*>(node)->updateControllers();
+        traverse(node, nv);
+    }
+};
+
+OpenVRControllerModels::OpenVRControllerModels(OpenVRDevice* device, OpenVRRenderModelLoader* loader, osg::Camera* camera) :
+    osg::Transform(),
+    m_device(device),
+    m_loader(loader),
+    m_camera(camera),
+    m_registryRevision(0)
+{
+    // The bound moves with the camera, which the cull visitor does not know about.
+    setCullingActive(false);
+    // Tracking space is scaled to world units, the normals of the models are not.
+    getOrCreateStateSet()->setMode(GL_RESCALE_NORMAL, osg::StateAttribute::ON);
+    setUpdateCallback(new OpenVRControllerModelsUpdateCallback);
+}
+
+bool OpenVRControllerModels::computeLocalToWorldMatrix(osg::Matrix& matrix, osg::NodeVisitor*) const
+{
+    if (_referenceFrame == RELATIVE_RF)
+    {
+        matrix.preMult(trackingToWorld());
+    }
+    else
+    {
+        matrix = trackingToWorld();
+    }
+    return true;
+}
+
+bool OpenVRControllerModels::computeWorldToLocalMatrix(osg::Matrix& matrix, osg::NodeVisitor*) const
+{
+    const osg::Matrix worldToTracking = osg::Matrix::inverse(trackingToWorld());
+    if (_referenceFrame == RELATIVE_RF)
+    {
+        matrix.postMult(worldToTracking);
+    }
+    else
+    {
+        matrix = worldToTracking;
+    }
+    return true;
+}
+
+/* Protected functions */
+void OpenVRControllerModels::updateControllers()
+{
+    osg::ref_ptr<OpenVRDevice> device;
+    if (!m_device.lock(device) || device->deviceRegistry() == nullptr)
+    {
+        return;
+    }
+
+    // Controllers only come and go with device events.
+    OpenVRDeviceRegistry* registry = device->deviceRegistry();
+    if (registry->revision() != m_registryRevision)
+    {
+        m_registryRevision = registry->revision();
+
+        std::vector<OpenVRTrackedDevice> devices;
+        registry->controllers(devices);
+
+        removeChildren(0, getNumChildren());
+        std::vector<Controller> controllers;
+        for (const OpenVRTrackedDevice& trackedDevice : devices)
+        {
+            Controller controller;
+            controller.index = trackedDevice.index;
+            controller.renderModelName = trackedDevice.renderModelName;
+            // Keep the transform of a controller that is still connected.
+            for (const Controller& previous : m_controllers)
+            {
+                if (previous.index == controller.index && previous.renderModelName == controller.renderModelName)
+                {
+                    controller.transform = previous.transform;
+                }
+            }
+            if (!controller.transform.valid())
+            {
+                controller.transform = new osg::MatrixTransform;
+                controller.transform->setName(trackedDevice.serialNumber);
+                m_loader->request(controller.renderModelName);
+            }
+            addChild(controller.transform.get());
+            controllers.push_back(controller);
+        }
+        m_controllers.swap(controllers);
+    }
+
+    for (const Controller& controller : m_controllers)
+    {
+        if (controller.transform->getNumChildren() == 0)
+        {
+            osg::Node* model = compiledModel(controller.renderModelName);
+            if (model != nullptr)
+            {
+                controller.transform->addChild(model);
+            }
+        }
+
+        const OpenVRPoseHistory& history = device->poseHistory(controller.index);
+        controller.transform->setNodeMask(history.empty() ? 0x0 : ~0x0);
+        if (!history.empty())
+        {
+            const OpenVRPoseSample& pose = history.latest();
+            controller.transform->setMatrix(osg::Matrix::rotate(pose.orientation) * osg::Matrix::translate(pose.position));
+        }
+    }
+}
+
+osg::Node* OpenVRControllerModels::compiledModel(const std::string& name)
+{
+    Model& model = m_models[name];
+    if (!model.node.valid())
+    {
+        model.node = m_loader->model(name);
+        if (!model.node.valid())
+        {
+            return nullptr;
+        }
+
+        // Compiled on the graphics thread between frames, attached once that has finished.
+        osg::ref_ptr<osgUtil::IncrementalCompileOperation> incrementalCompile;
+        if (m_incrementalCompile.lock(incrementalCompile))
+        {
+            model.compileSet = new osgUtil::IncrementalCompileOperation::CompileSet(model.node.get());
+            incrementalCompile->add(model.compileSet.get());
+        }
+    }
+
+    if (model.compileSet.valid() && !model.compileSet->compiled())
+    {
+        return nullptr;
+    }
+    return model.node.get();
+}
+
+osg::Matrix OpenVRControllerModels::trackingToWorld() const
+{
+    // The eye cameras see tracking space, scaled to world units, through the view of this camera.
+    osg::ref_ptr<osg::Camera> camera;
+    osg::ref_ptr<OpenVRDevice> device;
+    if (!m_camera.lock(camera) || !m_device.lock(device))
+    {
+        return osg::Matrix::identity();
+    }
+    const float scale = device->worldUnitsPerMetre();
+    return osg::Matrix::scale(scale, scale, scale) * camera->getInverseViewMatrix();
+}
@@ -0,0 +1,74 @@
+/*
+ * openvrcontrollermodels.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRCONTROLLERMODELS_H_
+#define _OSG_OPENVRCONTROLLERMODELS_H_
+
+#include <osg/Transform>
+#include <osg/MatrixTransform>
+#include <osg/Camera>
+#include <osg/observer_ptr>
+#include <osgUtil/IncrementalCompileOperation>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "openvrrendermodelloader.h"
+
+// Forward declaration
+class OpenVRDevice;
+
+// Shows the render model of every connected controller at its tracked pose. The children
+// are in tracking space, which this transform places in front of the given camera the way
+// the eye cameras see it, so the controllers stay in the hands while the view is navigated.
+// Controllers are added and removed when the device registry changes and a model is only
+// attached once the loader has it; with an incremental compile operation its GL objects
+// are also compiled before, so a controller appearing does not stall a frame.
+class OpenVRControllerModels : public osg::Transform
+{
+public:
+    OpenVRControllerModels(OpenVRDevice* device, OpenVRRenderModelLoader* loader, osg::Camera* camera);
+
+    // Compile operation of the viewer, see osgViewer::ViewerBase::setIncrementalCompileOperation().
+    void setIncrementalCompileOperation(osgUtil::IncrementalCompileOperation* ico) { m_incrementalCompile = ico; }
+
+    virtual bool computeLocalToWorldMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const;
+    virtual bool computeWorldToLocalMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const;
+
+    // Called by the update callback.
+    void updateControllers();
+
+protected:
+    ~OpenVRControllerModels() {}
+
+    osg::Node* compiledModel(const std::string& name);
+    osg::Matrix trackingToWorld() const;
+
+    struct Controller
+    {
+        unsigned int index;
+        std::string renderModelName;
+        osg::ref_ptr<osg::MatrixTransform> transform;
+    };
+
+    // A loaded model waiting for its GL objects to be compiled.
+    struct Model
+    {
+        osg::ref_ptr<osg::Node> node;
+        osg::ref_ptr<osgUtil::IncrementalCompileOperation::CompileSet> compileSet;
+    };
+
+    osg::observer_ptr<OpenVRDevice> m_device;
+    osg::ref_ptr<OpenVRRenderModelLoader> m_loader;
+    osg::observer_ptr<osg::Camera> m_camera;
+    osg::observer_ptr<osgUtil::IncrementalCompileOperation> m_incrementalCompile;
+
+    unsigned int m_registryRevision;
+    std::vector<Controller> m_controllers;
+    std::map<std::string, Model> m_models;
+};
+
+#endif /* _OSG_OPENVRCONTROLLERMODELS_H_ */
@@ -13,12 +13,123 @@
 #endif
 
 #include <osg/Geometry>
+#include <osg/GLExtensions>
+#include <osg/Image>
+#include <osg/Timer>
 #include <osgViewer/GraphicsWindow>
 
 #ifndef GL_TEXTURE_MAX_LEVEL
     #define GL_TEXTURE_MAX_LEVEL 0x813D
 #endif
 
+#ifndef GL_TIME_ELAPSED
+    #define GL_TIME_ELAPSED 0x88BF
+#endif
+
+#ifndef GL_QUERY_RESULT
+    #define GL_QUERY_RESULT 0x8866
+    #define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+    #define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+    #define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+    #define GL_TIMEOUT_EXPIRED 0x911B
+    #define GL_WAIT_FAILED 0x911D
+#endif
+
+#ifndef GL_CLIP_DISTANCE0
+    #define GL_CLIP_DISTANCE0 0x3000
+    #define GL_CLIP_DISTANCE1 0x3001
+#endif
+
+// Single pass stereo: the vertex shader outputs view space positions of the shared
+// (head) camera, the geometry shader emits every triangle once per eye, projects it
+// with that eye's projection and squeezes it into its half of the side-by-side target.
+// The clip distances keep each copy inside its own half. The fragment shader lights like
+// the fixed function pipeline with light 0; whether lighting is on and whether the material
+// takes its colors from the vertices come from uniforms, see OpenVRSinglePassStateVisitor.
+// The geometry shader takes triangles, lines and points are not drawn.
+static const char* s_singlePassVertexShader =
+    "#version 150 compatibility\n"
+    "uniform mat4 osgvr_LateLatch;\n"
+    "out vec3 osgvr_position;\n"
+    "out vec3 osgvr_normal;\n"
+    "out vec4 osgvr_color;\n"
+    "out vec2 osgvr_texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 position = gl_ModelViewMatrix * gl_Vertex;\n"
+    "    osgvr_position = position.xyz / position.w;\n"
+    "    osgvr_normal = gl_NormalMatrix * gl_Normal;\n"
+    "    osgvr_color = gl_Color;\n"
+    "    osgvr_texCoord = gl_MultiTexCoord0.xy;\n"
+    "    gl_Position = osgvr_LateLatch * position;\n"
+    "}\n";
+
+static const char* s_singlePassGeometryShader =
+    "#version 150 compatibility\n"
+    "layout(triangles) in;\n"
+    "layout(triangle_strip, max_vertices = 6) out;\n"
+    "uniform mat4 osgvr_EyeProjection[2];\n"
+    "in vec3 osgvr_position[];\n"
+    "in vec3 osgvr_normal[];\n"
+    "in vec4 osgvr_color[];\n"
+    "in vec2 osgvr_texCoord[];\n"
+    "out vec3 position;\n"
+    "out vec3 normal;\n"
+    "out vec4 color;\n"
+    "out vec2 texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    for (int eye = 0; eye < 2; ++eye)\n"
+    "    {\n"
+    "        float offset = (eye == 0) ? -0.5 : 0.5;\n"
+    "        for (int i = 0; i < 3; ++i)\n"
+    "        {\n"
+    "            vec4 clip = osgvr_EyeProjection[eye] * gl_in[i].gl_Position;\n"
+    "            gl_ClipDistance[0] = clip.x + clip.w;\n"
+    "            gl_ClipDistance[1] = clip.w - clip.x;\n"
+    "            gl_Position = vec4(0.5 * clip.x + offset * clip.w, clip.yzw);\n"
+    "            position = osgvr_position[i];\n"
+    "            normal = osgvr_normal[i];\n"
+    "            color = osgvr_color[i];\n"
+    "            texCoord = osgvr_texCoord[i];\n"
+    "            EmitVertex();\n"
+    "        }\n"
+    "        EndPrimitive();\n"
+    "    }\n"
+    "}\n";
+
+static const char* s_singlePassFragmentShader =
+    "#version 150 compatibility\n"
+    "uniform sampler2D osgvr_Texture0;\n"
+    "uniform bool osgvr_Lighting;\n"
+    "uniform bool osgvr_ColorMaterial;\n"
+    "in vec3 position;\n"
+    "in vec3 normal;\n"
+    "in vec4 color;\n"
+    "in vec2 texCoord;\n"
+    "void main()\n"
+    "{\n"
+    "    vec4 base = color;\n"
+    "    if (osgvr_Lighting)\n"
+    "    {\n"
+    "        vec4 ambient = osgvr_ColorMaterial ? color : gl_FrontMaterial.ambient;\n"
+    "        vec4 diffuse = osgvr_ColorMaterial ? color : gl_FrontMaterial.diffuse;\n"
+    "        vec3 n = normalize(gl_FrontFacing ? normal : -normal);\n"
+    "        vec3 l = normalize(gl_LightSource[0].position.xyz - position * gl_LightSource[0].position.w);\n"
+    "        float lambert = max(dot(n, l), 0.0);\n"
+    "        float specular = (lambert > 0.0) ? pow(max(dot(n, normalize(l - normalize(position))), 1e-4), gl_FrontMaterial.shininess) : 0.0;\n"
+    "        base.rgb = gl_FrontMaterial.emission.rgb\n"
+    "                 + ambient.rgb * (gl_LightModel.ambient.rgb + gl_LightSource[0].ambient.rgb)\n"
+    "                 + diffuse.rgb * gl_LightSource[0].diffuse.rgb * lambert\n"
+    "                 + gl_FrontMaterial.specular.rgb * gl_LightSource[0].specular.rgb * specular;\n"
+    "        base.a = diffuse.a;\n"
+    "    }\n"
+    "    gl_FragColor = base * texture(osgvr_Texture0, texCoord);\n"
+    "}\n";
+
 static const OSG_GLExtensions* getGLExtensions(const osg::State& state)
 {
 #if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
@@ -28,6 +139,24 @@ static const OSG_GLExtensions* getGLExtensions(const osg::State& state)
 #endif
 }
 
+static const OSG_Query_Extensions* getQueryExtensions(const osg::State& state)
+{
+#if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
+    return state.get<osg::GLExtensions>();
+#else
+    return osg::Drawable::getExtensions(state.getContextID(), true);
+#endif
+}
+
+static bool timerQuerySupported(const osg::State& state)
+{
+#if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
+    return state.get<osg::GLExtensions>()->isARBTimerQuerySupported;
+#else
+    return osg::Drawable::getExtensions(state.getContextID(), true)->isARBTimerQuerySupported();
+#endif
+}
+
 static const OSG_Texture_Extensions* getTextureExtensions(const osg::State& state)
 {
 #if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
@@ -37,6 +166,18 @@ static const OSG_Texture_Extensions* getTextureExtensions(const osg::State& stat
 #endif
 }
 
+// Checks the FBO currently bound to GL_FRAMEBUFFER.
+static bool checkFramebufferStatus(const OSG_GLExtensions* fbo_ext, const char* name)
+{
+    GLenum status = fbo_ext->glCheckFramebufferStatus(GL_FRAMEBUFFER_EXT);
+    if (status != GL_FRAMEBUFFER_COMPLETE_EXT)
+    {
+        osg::notify(osg::WARN) << "Error setting up " << name << " frame buffer object, status 0x" << std::hex << status << std::dec << std::endl;
+        return false;
+    }
+    return true;
+}
+
 static osg::Matrix convertMatrix34(const vr::HmdMatrix34_t &mat34)
 {
     osg::Matrix matrix(
@@ -48,6 +189,15 @@ static osg::Matrix convertMatrix34(const vr::HmdMatrix34_t &mat34)
     return matrix;
 }
 
+// Identity until OpenVRPreDrawCallback sets the correction, changed during the draw.
+static osg::Uniform* createLateLatchUniform(osg::StateSet* stateSet)
+{
+    osg::ref_ptr<osg::Uniform> lateLatch = new osg::Uniform("osgvr_LateLatch", osg::Matrixf());
+    lateLatch->setDataVariance(osg::Object::DYNAMIC);
+    stateSet->addUniform(lateLatch.get());
+    return lateLatch.get();
+}
+
 static osg::Matrix convertMatrix44(const vr::HmdMatrix44_t &mat44)
 {
     osg::Matrix matrix(
@@ -61,38 +211,164 @@ static osg::Matrix convertMatrix44(const vr::HmdMatrix44_t &mat44)
 
 void OpenVRPreDrawCallback::operator()(osg::RenderInfo& renderInfo) const
 {
-    m_textureBuffer->onPreRender(renderInfo);
+    if (m_startBuffer)
+    {
+        m_textureBuffer->onPreRender(renderInfo);
+    }
+    else
+    {
+        m_textureBuffer->bind(renderInfo);
+    }
+
+    for (int eye = OpenVRDevice::LEFT; eye < OpenVRDevice::COUNT; ++eye)
+    {
+        if (m_eye == eye || m_eye == OpenVRDevice::COUNT)
+        {
+            m_device->beginEyePass(renderInfo, static_cast<OpenVRDevice::Eye>(eye), m_camera->getClearColor());
+        }
+    }
+
+    // Set before the leaves are drawn, the camera's state set is applied with the first of them.
+    if (m_lateLatch.valid() && m_device->lateLatch())
+    {
+        const osg::Matrix eyeView = (m_eye == OpenVRDevice::LEFT) ? m_device->viewMatrixLeft()
+                                  : (m_eye == OpenVRDevice::RIGHT) ? m_device->viewMatrixRight()
+                                  : m_device->viewMatrixCombined();
+        m_lateLatch->set(osg::Matrixf(m_device->lateLatchCorrection(eyeView)));
+    }
 }
 
 void OpenVRPostDrawCallback::operator()(osg::RenderInfo& renderInfo) const
 {
-    m_textureBuffer->onPostRender(renderInfo);
+    if (m_resolve)
+    {
+        m_textureBuffer->onPostRender(renderInfo);
+    }
 }
 
 /* Public functions */
-OpenVRTextureBuffer::OpenVRTextureBuffer(osg::ref_ptr<osg::State> state, int width, int height, int samples) :
-    m_Resolve_FBO(0),
-    m_Resolve_ColorTex(0),
+OpenVRExtensions::OpenVRExtensions() :
+    glFenceSync(nullptr),
+    glClientWaitSync(nullptr),
+    glDeleteSync(nullptr),
+    glInvalidateFramebuffer(nullptr)
+{
+    osg::setGLExtensionFuncPtr(glFenceSync, "glFenceSync");
+    osg::setGLExtensionFuncPtr(glClientWaitSync, "glClientWaitSync");
+    osg::setGLExtensionFuncPtr(glDeleteSync, "glDeleteSync");
+    osg::setGLExtensionFuncPtr(glInvalidateFramebuffer, "glInvalidateFramebuffer");
+}
+
+OpenVRHiddenAreaMesh::OpenVRHiddenAreaMesh(const vr::HiddenAreaMesh_t& mesh) :
+    m_geometry(new osg::Geometry),
+    m_coverage(0.0f),
+    m_identity(new osg::RefMatrix),
+    m_depth(new osg::Depth(osg::Depth::ALWAYS, 0.0, 1.0, true)),
+    m_colorMask(new osg::ColorMask(false, false, false, false)),
+    m_program(new osg::Program)
+{
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array;
+    m_geometry->setVertexArray(vertices.get());
+    m_geometry->setUseDisplayList(false);
+    m_geometry->setUseVertexBufferObjects(true);
+    if (mesh.pVertexData == nullptr)
+    {
+        return;
+    }
+
+    // Texture coordinates of the eye's viewport to clip coordinates at the near plane.
+    vertices->reserve(mesh.unTriangleCount * 3);
+    for (uint32_t i = 0; i < mesh.unTriangleCount * 3; ++i)
+    {
+        vertices->push_back(osg::Vec3(2.0f * mesh.pVertexData[i].v[0] - 1.0f, 2.0f * mesh.pVertexData[i].v[1] - 1.0f, -1.0f));
+    }
+    m_geometry->addPrimitiveSet(new osg::DrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(vertices->size())));
+
+    // The triangles do not overlap, so their summed area is the hidden fraction of the eye.
+    // The clip space square has an area of 4.
+    for (size_t i = 0; i + 2 < vertices->size(); i += 3)
+    {
+        const osg::Vec3 a = (*vertices)[i + 1] - (*vertices)[i];
+        const osg::Vec3 b = (*vertices)[i + 2] - (*vertices)[i];
+        m_coverage += 0.125f * fabs(a.x() * b.y() - a.y() * b.x());
+    }
+}
+
+void OpenVRHiddenAreaMesh::draw(osg::RenderInfo& renderInfo, const osg::Viewport* viewport) const
+{
+    // Depth only, at window depth 0, independent of any scene program still bound.
+    osg::State& state = *renderInfo.getState();
+    state.applyAttribute(viewport);
+    state.applyAttribute(m_program.get());
+    state.applyAttribute(m_depth.get());
+    state.applyAttribute(m_colorMask.get());
+    state.applyMode(GL_DEPTH_TEST, true);
+    state.applyMode(GL_CULL_FACE, false);
+    state.applyProjectionMatrix(m_identity.get());
+    state.applyModelViewMatrix(m_identity.get());
+
+    m_geometry->draw(renderInfo);
+}
+
+OpenVRTextureBuffer::OpenVRTextureBuffer(osg::ref_ptr<osg::State> state, int width, int height, int samples, int resolveBuffers) :
+    m_resolveIndex(0),
+    m_resolveStallMs(0.0),
     m_MSAA_FBO(0),
     m_MSAA_ColorTex(0),
     m_MSAA_DepthTex(0),
     m_width(width),
     m_height(height),
-    m_samples(samples)
+    m_renderWidth(width),
+    m_renderHeight(height),
+    m_samples(samples),
+    m_timerQueryIndex(0),
+    m_gpuTimeMs(0.0),
+    m_glCalls(0)
 {
     const OSG_GLExtensions* fbo_ext = getGLExtensions(*state);
 
+    // Timer queries are used round robin, a result is read when the query is reused
+    // some frames later so reading it does not stall the pipeline.
+    for (int i = 0; i < TIMER_QUERY_COUNT; ++i)
+    {
+        m_timerQuery[i] = 0;
+    }
+    if (timerQuerySupported(*state))
+    {
+        getQueryExtensions(*state)->glGenQueries(TIMER_QUERY_COUNT, m_timerQuery);
+    }
+
     // We don't want to support MIPMAP so, ensure only level 0 is allowed.
     const int maxTextureLevel = 0;
 
-    // Create an FBO for secondary render target ready for application of lens distortion shader.
-    fbo_ext->glGenFramebuffers(1, &m_Resolve_FBO);
+    // Without sync objects there is no way to tell when the compositor is done with a texture.
+    if (resolveBuffers > 1 && !m_glExt.syncAvailable())
+    {
+        osg::notify(osg::WARN) << "Warning: GL sync objects not available, using a single resolve texture." << std::endl;
+        resolveBuffers = 1;
+    }
+
+    m_Resolve_ColorTex.resize(osg::maximum(resolveBuffers, 1), 0);
+    m_Resolve_Fence.resize(m_Resolve_ColorTex.size(), nullptr);
+    glGenTextures(static_cast<GLsizei>(m_Resolve_ColorTex.size()), m_Resolve_ColorTex.data());
+    for (GLuint texture : m_Resolve_ColorTex)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxTextureLevel);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
 
-    glGenTextures(1, &m_Resolve_ColorTex);
-    glBindTexture(GL_TEXTURE_2D, m_Resolve_ColorTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxTextureLevel);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    // Create an FBO for each resolve texture, ready for application of lens distortion shader.
+    // The attachments never change, so per frame only the FBOs have to be bound.
+    m_Resolve_FBO.resize(m_Resolve_ColorTex.size(), 0);
+    fbo_ext->glGenFramebuffers(static_cast<GLsizei>(m_Resolve_FBO.size()), m_Resolve_FBO.data());
+    for (size_t i = 0; i < m_Resolve_FBO.size(); ++i)
+    {
+        fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, m_Resolve_FBO[i]);
+        fbo_ext->glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_Resolve_ColorTex[i], 0);
+        checkFramebufferStatus(fbo_ext, "resolve");
+    }
 
     // Create an FBO for primary render target.
     fbo_ext->glGenFramebuffers(1, &m_MSAA_FBO);
@@ -119,23 +395,46 @@ OpenVRTextureBuffer::OpenVRTextureBuffer(osg::ref_ptr<osg::State> state, int wid
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_MAX_LEVEL, maxTextureLevel);
 
-    // check FBO status
-    GLenum status = fbo_ext->glCheckFramebufferStatus(GL_FRAMEBUFFER_EXT);
-    if (status != GL_FRAMEBUFFER_COMPLETE_EXT)
-    {
-        osg::notify(osg::WARN) << "Error setting up frame buffer object." << std::endl;
-    }
+    fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, m_MSAA_FBO);
+    fbo_ext->glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D_MULTISAMPLE, m_MSAA_ColorTex, 0);
+    fbo_ext->glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_TEXTURE_2D_MULTISAMPLE, m_MSAA_DepthTex, 0);
+    checkFramebufferStatus(fbo_ext, "MSAA");
 
+    fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
 }
 
 void OpenVRTextureBuffer::onPreRender(osg::RenderInfo& renderInfo)
 {
     osg::State& state = *renderInfo.getState();
-    const OSG_GLExtensions* fbo_ext = getGLExtensions(state);
+
+    GLuint query = m_timerQuery[m_timerQueryIndex];
+    if (query != 0)
+    {
+        const OSG_Query_Extensions* query_ext = getQueryExtensions(state);
+
+        GLint available = 0;
+        query_ext->glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        ++m_glCalls;
+        if (available)
+        {
+            GLuint64EXT elapsed = 0;
+            query_ext->glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+            ++m_glCalls;
+            m_gpuTimeMs = elapsed * 1.0e-6;
+        }
+        query_ext->glBeginQuery(GL_TIME_ELAPSED, query);
+        ++m_glCalls;
+    }
+
+    bind(renderInfo);
+}
+
+void OpenVRTextureBuffer::bind(osg::RenderInfo& renderInfo)
+{
+    const OSG_GLExtensions* fbo_ext = getGLExtensions(*renderInfo.getState());
 
     fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, m_MSAA_FBO);
-    fbo_ext->glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D_MULTISAMPLE, m_MSAA_ColorTex, 0);
-    fbo_ext->glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_TEXTURE_2D_MULTISAMPLE, m_MSAA_DepthTex, 0);
+    ++m_glCalls;
 }
 
 void OpenVRTextureBuffer::onPostRender(osg::RenderInfo& renderInfo)
@@ -143,18 +442,87 @@ void OpenVRTextureBuffer::onPostRender(osg::RenderInfo& renderInfo)
     osg::State& state = *renderInfo.getState();
     const OSG_GLExtensions* fbo_ext = getGLExtensions(state);
 
+    // Resolve into the next texture of the ring. Its fence was set after it was submitted
+    // some frames ago, it only has to be waited for when the compositor is still reading it.
+    m_resolveIndex = (m_resolveIndex + 1) % static_cast<int>(m_Resolve_ColorTex.size());
+    m_resolveStallMs = 0.0;
+    OpenVRGLsync& fence = m_Resolve_Fence[m_resolveIndex];
+    if (fence != nullptr)
+    {
+        ++m_glCalls;
+        if (m_glExt.glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+        {
+            const osg::Timer_t startTick = osg::Timer::instance()->tick();
+            const uint64_t timeout = 100000000; // 100 ms
+            ++m_glCalls;
+            if (m_glExt.glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout) != GL_WAIT_FAILED)
+            {
+                m_resolveStallMs = osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+            }
+        }
+        m_glExt.glDeleteSync(fence);
+        ++m_glCalls;
+        fence = nullptr;
+    }
+
     fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, m_MSAA_FBO);
-    fbo_ext->glFramebufferTexture2D(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D_MULTISAMPLE, m_MSAA_ColorTex, 0);
-    fbo_ext->glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, 0);
+    fbo_ext->glBindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, m_Resolve_FBO[m_resolveIndex]);
 
-    fbo_ext->glBindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, m_Resolve_FBO);
-    fbo_ext->glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_Resolve_ColorTex, 0);
-    fbo_ext->glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, 0);
+    // Copy MSAA_FBO texture to Resolve_FBO, only the part that has been rendered to
+    fbo_ext->glBlitFramebuffer(0, 0, m_renderWidth, m_renderHeight, 0, 0, m_renderWidth, m_renderHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    m_glCalls += 3;
 
-    // Copy MSAA_FBO texture to Resolve_FBO
-    fbo_ext->glBlitFramebuffer(0, 0, m_width, m_height, 0, 0, m_width, m_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    // The multisampled images are not needed after the resolve, the next frame clears them.
+    // Lets tiled and bandwidth limited GPUs skip writing them back to memory.
+    if (m_glExt.glInvalidateFramebuffer != nullptr)
+    {
+        const GLenum attachments[2] = { GL_COLOR_ATTACHMENT0_EXT, GL_DEPTH_ATTACHMENT_EXT };
+        m_glExt.glInvalidateFramebuffer(GL_READ_FRAMEBUFFER_EXT, 2, attachments);
+        ++m_glCalls;
+    }
 
     fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
+    ++m_glCalls;
+
+    if (m_timerQuery[m_timerQueryIndex] != 0)
+    {
+        getQueryExtensions(state)->glEndQuery(GL_TIME_ELAPSED);
+        ++m_glCalls;
+        m_timerQueryIndex = (m_timerQueryIndex + 1) % TIMER_QUERY_COUNT;
+    }
+}
+
+void OpenVRTextureBuffer::onSubmitted()
+{
+    // With a single texture the next resolve is ordered after the submit by GL anyway.
+    if (m_Resolve_ColorTex.size() < 2)
+    {
+        return;
+    }
+
+    // The runtime copies the texture on this context during Submit, so a fence set
+    // afterwards signals when the texture may be overwritten.
+    OpenVRGLsync& fence = m_Resolve_Fence[m_resolveIndex];
+    if (fence != nullptr)
+    {
+        m_glExt.glDeleteSync(fence);
+        ++m_glCalls;
+    }
+    fence = m_glExt.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ++m_glCalls;
+}
+
+unsigned int OpenVRTextureBuffer::takeGLCallCount()
+{
+    unsigned int calls = m_glCalls;
+    m_glCalls = 0;
+    return calls;
+}
+
+void OpenVRTextureBuffer::setRenderSize(int width, int height)
+{
+    m_renderWidth = osg::minimum(static_cast<GLint>(width), m_width);
+    m_renderHeight = osg::minimum(static_cast<GLint>(height), m_height);
 }
 
 void OpenVRTextureBuffer::destroy(osg::GraphicsContext* gc)
@@ -163,186 +531,321 @@ void OpenVRTextureBuffer::destroy(osg::GraphicsContext* gc)
     if (fbo_ext)
     {
         fbo_ext->glDeleteFramebuffers(1, &m_MSAA_FBO);
-        fbo_ext->glDeleteFramebuffers(1, &m_Resolve_FBO);
+        fbo_ext->glDeleteFramebuffers(static_cast<GLsizei>(m_Resolve_FBO.size()), m_Resolve_FBO.data());
     }
+    glDeleteTextures(1, &m_MSAA_ColorTex);
+    glDeleteTextures(1, &m_MSAA_DepthTex);
+
+    if (m_timerQuery[0] != 0)
+    {
+        getQueryExtensions(*gc->getState())->glDeleteQueries(TIMER_QUERY_COUNT, m_timerQuery);
+    }
+
+    for (OpenVRGLsync& fence : m_Resolve_Fence)
+    {
+        if (fence != nullptr)
+        {
+            m_glExt.glDeleteSync(fence);
+            fence = nullptr;
+        }
+    }
+    glDeleteTextures(static_cast<GLsizei>(m_Resolve_ColorTex.size()), m_Resolve_ColorTex.data());
 }
 
-OpenVRMirrorTexture::OpenVRMirrorTexture(osg::ref_ptr<osg::State> state, GLint width, GLint height) : 
-    m_width(width),
-    m_height(height)
+// Frames the eye buffers are mirrored after the compositor mirror failed before it is tried again.
+static const unsigned int s_compositorMirrorRetryFrames = 90;
+
+OpenVRMirrorTexture::OpenVRMirrorTexture(OpenVRBackend* backend) :
+    m_backend(backend),
+    m_compositorWidth(0),
+    m_compositorHeight(0),
+    m_compositorAcquired(false),
+    m_glCalls(0)
 {
-    const OSG_GLExtensions* fbo_ext = getGLExtensions(*state);
+    for (int i = 0; i < 2; ++i)
+    {
+        m_compositorFBO[i] = 0;
+        m_compositorTex[i] = 0;
+        m_compositorHandle[i] = nullptr;
+    }
+}
 
-    // Configure the mirror FBO
-    fbo_ext->glGenFramebuffers(1, &m_mirrorFBO);
-    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, m_mirrorFBO);
+void OpenVRMirrorTexture::blitTexture(osg::GraphicsContext* gc, OpenVRTextureBuffer* leftEye, const osg::Viewport* leftRect,
+                                      OpenVRTextureBuffer* rightEye, const osg::Viewport* rightRect)
+{
+    const OSG_GLExtensions* fbo_ext = getGLExtensions(*(gc->getState()));
+    const GLint windowWidth = gc->getTraits()->width;
+    const GLint windowHeight = gc->getTraits()->height;
 
-    glGenTextures(1, &m_mirrorTex);
-    glBindTexture(GL_TEXTURE_2D, m_mirrorTex);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_width, m_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    // The eye images are scaled straight into the back buffer, which they cover completely.
+    fbo_ext->glBindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, 0);
+    ++m_glCalls;
 
-    fbo_ext->glFramebufferTexture2D(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_mirrorTex, 0);
-    fbo_ext->glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, 0);
-    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, 0);
+    if (leftEye == nullptr || rightEye == nullptr)
+    {
+        OpenVRTextureBuffer* eyeBuffer = leftEye != nullptr ? leftEye : rightEye;
+        const osg::Viewport* rect = leftEye != nullptr ? leftRect : rightRect;
+        copyToWindow(fbo_ext, eyeBuffer->m_Resolve_FBO[eyeBuffer->m_resolveIndex], rect->x(), rect->y(), rect->width(), rect->height(),
+                     0, windowWidth, windowHeight);
+    }
+    else if (leftEye == rightEye && rightRect->x() == leftRect->x() + leftRect->width() && rightRect->y() == leftRect->y())
+    {
+        // In an eye atlas both eyes are next to each other and copied at once.
+        copyToWindow(fbo_ext, leftEye->m_Resolve_FBO[leftEye->m_resolveIndex], leftRect->x(), leftRect->y(), leftRect->width() + rightRect->width(), leftRect->height(),
+                     0, windowWidth, windowHeight);
+    }
+    else
+    {
+        copyToWindow(fbo_ext, leftEye->m_Resolve_FBO[leftEye->m_resolveIndex], leftRect->x(), leftRect->y(), leftRect->width(), leftRect->height(),
+                     0, windowWidth / 2, windowHeight);
+        copyToWindow(fbo_ext, rightEye->m_Resolve_FBO[rightEye->m_resolveIndex], rightRect->x(), rightRect->y(), rightRect->width(), rightRect->height(),
+                     windowWidth / 2, windowWidth, windowHeight);
+    }
 
+    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, 0);
+    ++m_glCalls;
 }
 
-void OpenVRMirrorTexture::blitTexture(osg::GraphicsContext* gc, OpenVRTextureBuffer* leftEye,  OpenVRTextureBuffer* rightEye)
+bool OpenVRMirrorTexture::blitCompositorTexture(osg::GraphicsContext* gc)
 {
+    if (!m_compositorAcquired && !acquireCompositorTextures(gc))
+    {
+        return false;
+    }
+
     const OSG_GLExtensions* fbo_ext = getGLExtensions(*(gc->getState()));
+    const GLint windowWidth = gc->getTraits()->width;
+    const GLint windowHeight = gc->getTraits()->height;
 
-    fbo_ext->glBindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, m_mirrorFBO);
-    fbo_ext->glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_mirrorTex, 0);
-    fbo_ext->glFramebufferRenderbuffer(GL_DRAW_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, 0);
+    fbo_ext->glBindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, 0);
+    ++m_glCalls;
 
-    glClearColor(1, 0, 0, 1);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    for (int i = 0; i < 2; ++i)
+    {
+        // The compositor must not write the texture while it is read.
+        m_backend->lockMirrorTexture(m_compositorHandle[i]);
+        copyToWindow(fbo_ext, m_compositorFBO[i], 0, 0, m_compositorWidth, m_compositorHeight,
+                     i * windowWidth / 2, (i + 1) * windowWidth / 2, windowHeight);
+        m_backend->unlockMirrorTexture(m_compositorHandle[i]);
+    }
 
-    //--------------------------------
-    // Copy left eye image to mirror
-    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, leftEye->m_Resolve_FBO);
-    fbo_ext->glFramebufferTexture2D(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D,leftEye->m_Resolve_ColorTex, 0);
-    fbo_ext->glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, 0);
-
-    fbo_ext->glBlitFramebuffer(0, 0, leftEye->m_width, leftEye->m_height,
-                               0, 0, m_width / 2, m_height,
-                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    //--------------------------------
-    // Copy right eye image to mirror
-    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, rightEye->m_Resolve_FBO);
-    fbo_ext->glFramebufferTexture2D(GL_READ_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, rightEye->m_Resolve_ColorTex, 0);
-    fbo_ext->glFramebufferRenderbuffer(GL_READ_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, 0);
-
-    fbo_ext->glBlitFramebuffer(0, 0, rightEye->m_width, rightEye->m_height,
-                               m_width / 2, 0, m_width, m_height,
-                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    //---------------------------------
+    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, 0);
+    ++m_glCalls;
+    return true;
+}
 
+bool OpenVRMirrorTexture::acquireCompositorTextures(osg::GraphicsContext* gc)
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (!m_backend->mirrorTexture(static_cast<vr::EVREye>(i), m_compositorTex[i], m_compositorHandle[i]))
+        {
+            releaseCompositorTextures();
+            return false;
+        }
+    }
+
+    // Both eyes of the compositor mirror have the same size.
+    glBindTexture(GL_TEXTURE_2D, m_compositorTex[0]);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &m_compositorWidth);
+    glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &m_compositorHeight);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    const OSG_GLExtensions* fbo_ext = getGLExtensions(*(gc->getState()));
+    fbo_ext->glGenFramebuffers(2, m_compositorFBO);
+    for (int i = 0; i < 2; ++i)
+    {
+        fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, m_compositorFBO[i]);
+        fbo_ext->glFramebufferTexture2D(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, m_compositorTex[i], 0);
+        checkFramebufferStatus(fbo_ext, "compositor mirror");
+    }
     fbo_ext->glBindFramebuffer(GL_FRAMEBUFFER_EXT, 0);
 
-    // Blit mirror texture to back buffer
-    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, m_mirrorFBO);
-    fbo_ext->glBindFramebuffer(GL_DRAW_FRAMEBUFFER_EXT, 0);
-    GLint w = m_width;
-    GLint h = m_height;
-    fbo_ext->glBlitFramebuffer(0, 0, w, h,
-                               0, 0, w, h,
-                               GL_COLOR_BUFFER_BIT, GL_NEAREST);
-    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, 0);
+    m_compositorAcquired = true;
+    return true;
+}
+
+void OpenVRMirrorTexture::releaseCompositorTextures()
+{
+    for (int i = 0; i < 2; ++i)
+    {
+        if (m_compositorHandle[i] != nullptr)
+        {
+            m_backend->releaseMirrorTexture(m_compositorTex[i], m_compositorHandle[i]);
+        }
+        m_compositorTex[i] = 0;
+        m_compositorHandle[i] = nullptr;
+    }
+    m_compositorAcquired = false;
+}
+
+unsigned int OpenVRMirrorTexture::takeGLCallCount()
+{
+    unsigned int calls = m_glCalls;
+    m_glCalls = 0;
+    return calls;
+}
+
+void OpenVRMirrorTexture::copyToWindow(const OSG_GLExtensions* fbo_ext, GLuint readFBO, double x, double y, double width, double height,
+                                       GLint windowX0, GLint windowX1, GLint windowHeight)
+{
+    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, readFBO);
+
+    GLint x0 = static_cast<GLint>(x);
+    GLint y0 = static_cast<GLint>(y);
+    fbo_ext->glBlitFramebuffer(x0, y0, x0 + static_cast<GLint>(width), y0 + static_cast<GLint>(height),
+                               windowX0, 0, windowX1, windowHeight,
+                               GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    m_glCalls += 2;
 }
 
 void OpenVRMirrorTexture::destroy(osg::GraphicsContext* gc)
 {
     const OSG_GLExtensions* fbo_ext = getGLExtensions(*gc->getState());
-    if (fbo_ext)
+    if (fbo_ext && m_compositorFBO[0] != 0)
     {
-        fbo_ext->glDeleteFramebuffers(1, &m_mirrorFBO);
+        fbo_ext->glDeleteFramebuffers(2, m_compositorFBO);
+        m_compositorFBO[0] = m_compositorFBO[1] = 0;
     }
+    releaseCompositorTextures();
 }
 
 
 
 OpenVRDevice::OpenVRDevice(float nearClip, float farClip, const float worldUnitsPerMetre, const int samples) :
-    m_vrSystem(nullptr),
-    m_vrRenderModels(nullptr),
-    m_worldUnitsPerMetre(worldUnitsPerMetre),
-    m_mirrorTexture(nullptr),
-    m_position(osg::Vec3(0.0f, 0.0f, 0.0f)),
+    OpenVRDevice(nullptr, nearClip, farClip, worldUnitsPerMetre, samples)
+{
+}
+
+OpenVRDevice::OpenVRDevice(osg::ref_ptr<OpenVRBackend> backend, float nearClip, float farClip, const float worldUnitsPerMetre, const int samples) :
 	m_leftControllerPosition(osg::Vec3(0.0f, 0.0f, 0.0f)),
 	m_rightControllerPosition(osg::Vec3(0.0f, 0.0f, 0.0f)),
-    m_orientation(osg::Quat(0.0f, 0.0f, 0.0f, 1.0f)),
 	m_leftOrientation(osg::Quat(0.0f, 0.0f, 0.0f, 1.0f)),
 	m_rightOrientation(osg::Quat(0.0f, 0.0f, 0.0f, 1.0f)),
-	m_touchpadTouchPosition(osg::Vec2(0.0f, 0.0f)),
-	m_touchpadPreTouchPosition(osg::Vec2(0.0f,0.0f)),
+    m_backend(backend),
+    m_worldUnitsPerMetre(worldUnitsPerMetre),
+    m_mirrorTexture(nullptr),
+    m_stereoMode(MULTI_PASS),
+    m_eyeAtlas(false),
+    m_hiddenAreaMaskEnabled(true),
+    m_requestedResolutionScale(1.0f),
+    m_timedFrameIndex(0),
+    m_resolveBufferCount(2),
+    m_mirrorMode(MIRROR_BOTH),
+    m_mirrorInterval(1),
+    m_mirrorFrame(0),
+    m_compositorMirrorRetryFrame(0),
+    m_posePrediction(false),
+    m_predictionOffset(0.0f),
+    m_lateLatch(false),
+    m_controllersRevision(0),
+    m_poseWaitMs(0),
+    m_drawFrameStarted(false),
+    m_framesInFlight(0),
     m_nearClip(nearClip), m_farClip(farClip),
     m_samples(samples)
 {
+    initialize();
+}
 
+void OpenVRDevice::initialize()
+{
     for (int i = 0; i < 2; i++)
     {
         m_textureBuffer[i] = nullptr;
     }
 
-    trySetProcessAsHighPriority();
-
-    // Loading the SteamVR Runtime
-    vr::EVRInitError eError = vr::VRInitError_None;
-    m_vrSystem = vr::VR_Init(&eError, vr::VRApplication_Scene);
+    // Write masks used by beginEyePass(), applied through osg::State so it keeps track of them.
+    m_clearColorMask = new osg::ColorMask(true, true, true, true);
+    m_clearDepth = new osg::Depth(osg::Depth::LESS, 0.0, 1.0, true);
 
-    if (eError != vr::VRInitError_None)
-    {
-        m_vrSystem = nullptr;
-        osg::notify(osg::WARN) 
-            << "Error: Unable to initialize the OpenVR library.\n"
-            << "Reason: " << vr::VR_GetVRInitErrorAsEnglishDescription( eError ) << std::endl;
-        return;
-    }
+    trySetProcessAsHighPriority();
 
-    if ( !vr::VRCompositor() )
+    // Loading the SteamVR Runtime unless another backend has been supplied
+    if (!m_backend.valid())
     {
-        m_vrSystem = nullptr;
-        vr::VR_Shutdown();
-        osg::notify(osg::WARN) << "Error: Compositor initialization failed" << std::endl;
-        return;
+        m_backend = new OpenVRRuntimeBackend();
     }
 
-    m_vrRenderModels = (vr::IVRRenderModels *)vr::VR_GetGenericInterface(vr::IVRRenderModels_Version, &eError);
-    if (m_vrRenderModels == nullptr)
+    if (!m_backend->initialized())
     {
-        m_vrSystem = nullptr;
-        vr::VR_Shutdown();
-        osg::notify(osg::WARN) 
-            << "Error: Unable to get render model interface!\n"
-            << "Reason: " << vr::VR_GetVRInitErrorAsEnglishDescription( eError ) << std::endl;
+        // The reason for failure was reported by the backend.
+        m_backend = nullptr;
         return;
     }
 
-    std::string driverName = GetDeviceProperty(vr::Prop_TrackingSystemName_String);
-    std::string deviceSerialNumber = GetDeviceProperty(vr::Prop_SerialNumber_String);
+    std::string driverName = m_backend->trackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_TrackingSystemName_String);
+    std::string deviceSerialNumber = m_backend->trackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SerialNumber_String);
 
     osg::notify(osg::NOTICE) << "HMD driver name: "<< driverName << std::endl;
     osg::notify(osg::NOTICE) << "HMD device serial number: " << deviceSerialNumber << std::endl;
 
 }
 
-std::string OpenVRDevice::GetDeviceProperty(vr::TrackedDeviceProperty prop)
-{
-    uint32_t bufferLen = m_vrSystem->GetStringTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, prop, NULL, 0);
-    if (bufferLen == 0)
-    {
-        return "";
-    }
-
-    char* buffer = new char[bufferLen];
-    bufferLen = m_vrSystem->GetStringTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, prop, buffer, bufferLen);
-    std::string result = buffer;
-    delete [] buffer;
-    return result;
-}
-
 void OpenVRDevice::createRenderBuffers(osg::ref_ptr<osg::State> state)
 {
     uint32_t renderWidth = 0;
     uint32_t renderHeight = 0;
-    m_vrSystem->GetRecommendedRenderTargetSize(&renderWidth, &renderHeight);
+    m_backend->recommendedRenderTargetSize(renderWidth, renderHeight);
 
-    for (int i = 0; i < 2; i++)
+    if (eyeAtlas())
+    {
+        // Both eyes share one texture, left eye in the left half.
+        osg::ref_ptr<OpenVRTextureBuffer> buffer = new OpenVRTextureBuffer(state, 2 * renderWidth, renderHeight, m_samples, m_resolveBufferCount);
+        m_textureBuffer[LEFT] = buffer;
+        m_textureBuffer[RIGHT] = buffer;
+        m_eyeViewport[LEFT] = new osg::Viewport(0, 0, renderWidth, renderHeight);
+        m_eyeViewport[RIGHT] = new osg::Viewport(renderWidth, 0, renderWidth, renderHeight);
+    }
+    else
     {
-        m_textureBuffer[i] = new OpenVRTextureBuffer(state, renderWidth, renderHeight, m_samples);
+        for (int i = 0; i < 2; i++)
+        {
+            m_textureBuffer[i] = new OpenVRTextureBuffer(state, renderWidth, renderHeight, m_samples, m_resolveBufferCount);
+            m_eyeViewport[i] = new osg::Viewport(0, 0, renderWidth, renderHeight);
+        }
     }
+    m_stereoViewport = new osg::Viewport(0, 0, 2 * renderWidth, renderHeight);
 
-    int mirrorWidth = 800;
-    int mirrorHeight = 450;
-    m_mirrorTexture = new OpenVRMirrorTexture(state, mirrorWidth, mirrorHeight);
+    // A scale chosen before realize is applied now that the buffer size is known.
+    // No frame has been begun yet, so nothing is being drawn.
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_frameStateMutex);
+        m_frameState.resolutionScale = osg::clampBetween(m_requestedResolutionScale, 0.1f, 1.0f);
+        applyResolutionScale(m_frameState.resolutionScale);
+        m_drawFrameState = m_frameState;
+    }
+
+    m_mirrorTexture = new OpenVRMirrorTexture(m_backend.get());
 }
 
 void OpenVRDevice::init()
 {
+    // Already called before realize.
+    if (m_poseService.valid())
+    {
+        return;
+    }
+
     calculateEyeAdjustment();
     calculateProjectionMatrices();
+    calculateCombinedFrustum();
+
+    for (int eye = LEFT; eye < COUNT; ++eye)
+    {
+        m_hiddenAreaMesh[eye] = new OpenVRHiddenAreaMesh(m_backend->hiddenAreaMesh(eye == LEFT ? vr::Eye_Left : vr::Eye_Right));
+    }
+
+    // A frame begun without the poses after the last submit two refresh periods later
+    // uses the previous poses rather than holding up the update.
+    m_poseWaitMs = static_cast<unsigned int>(2000.0f / osg::maximum(m_backend->displayFrequency(), 1.0f)) + 1;
+
+    m_poseService = new OpenVRPoseService(m_backend.get());
+    m_poseService->start();
+
+    // Devices connected later are added by their activation events.
+    m_deviceRegistry = new OpenVRDeviceRegistry(m_backend.get());
+    m_deviceRegistry->scan();
 }
 
 bool OpenVRDevice::hmdPresent()
@@ -352,7 +855,7 @@ bool OpenVRDevice::hmdPresent()
 
 bool OpenVRDevice::hmdInitialized() const
 {
-    return m_vrSystem != nullptr && m_vrRenderModels != nullptr;
+    return m_backend.valid() && m_backend->initialized();
 }
 
 osg::Matrix OpenVRDevice::projectionMatrixCenter() const
@@ -362,6 +865,18 @@ osg::Matrix OpenVRDevice::projectionMatrixCenter() const
     return projectionMatrixCenter;
 }
 
+osg::Matrix OpenVRDevice::projectionMatrixCombined() const
+{
+    return m_combinedProjectionMatrix;
+}
+
+osg::Matrix OpenVRDevice::viewMatrixCombined() const
+{
+    osg::Matrix viewMatrix;
+    viewMatrix.makeTranslate(-m_combinedApex);
+    return viewMatrix;
+}
+
 osg::Matrix OpenVRDevice::projectionMatrixLeft() const
 {
     return m_leftEyeProjectionMatrix;
@@ -404,92 +919,273 @@ osg::Matrix OpenVRDevice::viewMatrixRight() const
 
 void OpenVRDevice::resetSensorOrientation() const
 {
-    m_vrSystem->ResetSeatedZeroPose();
+    m_backend->resetSeatedZeroPose();
 }
 
-void OpenVRDevice::updatePose()
+osg::Matrix OpenVRDevice::headViewOffset(const osg::Matrix& eyeView, const osg::Vec3& position, const osg::Quat& orientation)
 {
-    vr::VRCompositor()->SetTrackingSpace(vr::TrackingUniverseSeated);
+    osg::Matrix viewOffset = eyeView;
+    viewOffset.preMultRotate(orientation);
+    viewOffset.setTrans(viewOffset.getTrans() + position);
+    return viewOffset;
+}
 
+osg::Matrix OpenVRDevice::lateLatchCorrection(const osg::Matrix& eyeView) const
+{
+    const OpenVRFrameState& frame = drawFrameState();
 
-    for (int i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i) poses[i].bPoseIsValid = false;
-    vr::VRCompositor()->WaitGetPoses(poses, vr::k_unMaxTrackedDeviceCount, NULL, 0);
+    vr::TrackedDevicePose_t pose;
+    if (!m_backend->devicePoses(&pose, 1, m_backend->secondsToPhotons() + m_predictionOffset) || !pose.bPoseIsValid)
+    {
+        return osg::Matrix::identity();
+    }
+
+    osg::Vec3 position;
+    osg::Quat orientation;
+    headPose(pose, position, orientation);
+
+    // Eye coordinates of the culled view to those of the latest one
+    return osg::Matrix::inverse(headViewOffset(eyeView, frame.position, frame.orientation)) * headViewOffset(eyeView, position, orientation);
+}
 
+void OpenVRDevice::headPose(const vr::TrackedDevicePose_t& pose, osg::Vec3& position, osg::Quat& orientation) const
+{
+    OpenVRRigidPose rigidPose;
+    OpenVRPoseConversion::convert(&pose, 1, &rigidPose);
+    position = rigidPose.inversePosition * m_worldUnitsPerMetre;
+    orientation = rigidPose.inverseOrientation;
+}
+
+void OpenVRDevice::updatePose()
+{
     // Not sure why, but the openvr hellovr_opengl example only seems interested in the
     // pose transform from the first pose tracking device in the array.
     // i.e. this seems to be the only one that is used to affect the view transform matrix.
     // So, here we do the same.
-    const vr::TrackedDevicePose_t& pose = poses[vr::k_unTrackedDeviceIndex_Hmd];
-    if (pose.bPoseIsValid)
+    const OpenVRRigidPose& pose = m_rigidPoses[vr::k_unTrackedDeviceIndex_Hmd];
+    if (pose.valid)
     {
-        osg::Matrix matrix = convertMatrix34(pose.mDeviceToAbsoluteTracking);
-        osg::Matrix poseTransform = osg::Matrix::inverse(matrix);
-        m_position = poseTransform.getTrans() * m_worldUnitsPerMetre;
-        m_orientation = poseTransform.getRotate();
+        m_frameState.position = pose.inversePosition * m_worldUnitsPerMetre;
+        m_frameState.orientation = pose.inverseOrientation;
 		getControllerPose();
-		//std::cout << m_position.x() << "," << m_position.y() << "," << m_position.z() << "," << std::endl;
     }
+}
+
+void OpenVRDevice::recordPoseHistory()
+{
+    const OpenVRPoseSnapshot& snapshot = m_frameState.poses;
+    for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+    {
+        const vr::TrackedDevicePose_t& pose = snapshot.poses[i];
+        if (!pose.bDeviceIsConnected)
+        {
+            // A device appearing again in the slot starts a new history.
+            if (!m_poseHistory[i].empty())
+            {
+                m_poseHistory[i].clear();
+            }
+            continue;
+        }
+        if (!m_rigidPoses[i].valid)
+        {
+            continue;
+        }
+
+        OpenVRPoseSample sample;
+        sample.tick = snapshot.posesTick;
+        sample.position = m_rigidPoses[i].position;
+        sample.orientation = m_rigidPoses[i].orientation;
+        sample.velocity.set(pose.vVelocity.v[0], pose.vVelocity.v[1], pose.vVelocity.v[2]);
+        sample.angularVelocity.set(pose.vAngularVelocity.v[0], pose.vAngularVelocity.v[1], pose.vAngularVelocity.v[2]);
+        m_poseHistory[i].add(sample);
+    }
+}
+
+void OpenVRDevice::beginFrame(unsigned int frameNumber)
+{
+    // Waited for before taking the frame state lock, the draw thread needs it to submit.
+    // Once the last submitted frame has been followed by its poses this returns at once.
+    if (m_poseService.valid())
+    {
+        m_poseService->waitForLatestPoses(m_poseWaitMs);
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_frameStateMutex);
+
+    // The eye viewports are shared with the cameras and read by the draw thread, so a new scale
+    // waits until the frames in flight have been drawn. Should that take too long it is tried
+    // again with the next frame.
+    if (m_requestedResolutionScale != m_frameState.resolutionScale && m_textureBuffer[LEFT].valid())
+    {
+        if (m_framesInFlight > 0)
+        {
+            const unsigned long timeoutMs = 100;
+            m_frameDrawn.wait(&m_frameStateMutex, timeoutMs);
+        }
+        if (m_framesInFlight == 0)
+        {
+            m_frameState.resolutionScale = m_requestedResolutionScale;
+            applyResolutionScale(m_frameState.resolutionScale);
+        }
+    }
+
+    // The pose stays that of the previous frame until a newer snapshot has been published.
+    if (m_poseService.valid())
+    {
+        const OpenVRPoseSnapshot& snapshot = m_poseService->latest();
+        if (snapshot.frameIndex != m_frameState.poses.frameIndex)
+        {
+            m_frameState.poses = snapshot;
+            OpenVRPoseConversion::convert(snapshot.poses, vr::k_unMaxTrackedDeviceCount, m_rigidPoses);
+            recordPoseHistory();
+            updatePose();
+        }
+    }
+    m_frameState.frameNumber = frameNumber;
 
+    if (m_posePrediction && m_backend.valid())
+    {
+        predictPose();
+        recordPredictionError();
+    }
 
+    // Frames are drawn in order, at most a couple are in flight. Should frames be updated
+    // without ever being drawn, the oldest are dropped rather than queued forever.
+    const size_t maxQueuedFrames = 4;
+    if (m_queuedFrames.size() >= maxQueuedFrames)
+    {
+        m_queuedFrames.pop_front();
+        --m_framesInFlight;
+    }
+    m_queuedFrames.push_back(m_frameState);
+    ++m_framesInFlight;
 }
 
-void OpenVRDevice::getControllerPose()
+const OpenVRFrameState& OpenVRDevice::drawFrameState() const
 {
+    if (!m_drawFrameStarted)
+    {
+        // Without a queued frame, e.g. when drawing before the first update, the last state is kept.
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_frameStateMutex);
+        if (!m_queuedFrames.empty())
+        {
+            m_drawFrameState = m_queuedFrames.front();
+            m_queuedFrames.pop_front();
+            m_drawFrameStarted = true;
+        }
+    }
+    return m_drawFrameState;
+}
 
-	for (vr::TrackedDeviceIndex_t unTrackedDevice = vr::k_unTrackedDeviceIndex_Hmd + 1; unTrackedDevice < vr::k_unMaxTrackedDeviceCount; ++unTrackedDevice)
+void OpenVRDevice::endDrawFrame()
+{
+    drawFrameState();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_frameStateMutex);
+    if (m_drawFrameStarted)
+    {
+        m_drawFrameStarted = false;
+        --m_framesInFlight;
+        m_frameDrawn.broadcast();
+    }
+}
+
+void OpenVRDevice::predictPose()
+{
+    const float secondsToPhotons = m_backend->secondsToPhotons() + m_predictionOffset;
+
+    vr::TrackedDevicePose_t pose;
+    if (!m_backend->devicePoses(&pose, 1, secondsToPhotons) || !pose.bPoseIsValid)
+    {
+        return;
+    }
+    OpenVRRigidPose rigidPose;
+    OpenVRPoseConversion::convert(&pose, 1, &rigidPose);
+    m_frameState.position = rigidPose.inversePosition * m_worldUnitsPerMetre;
+    m_frameState.orientation = rigidPose.inverseOrientation;
+
+    // The device pose in tracking space, so the error is in metres whatever the world units
+    PosePrediction prediction;
+    prediction.photonTick = osg::Timer::instance()->tick() + static_cast<osg::Timer_t>(secondsToPhotons / osg::Timer::instance()->getSecondsPerTick());
+    prediction.position = rigidPose.position;
+    prediction.orientation = rigidPose.orientation;
+
+    // Predictions are checked every frame, so only a couple are ever waiting.
+    const size_t maxPredictions = 16;
+    if (m_predictions.size() >= maxPredictions)
+    {
+        m_predictions.pop_front();
+    }
+    m_predictions.push_back(prediction);
+}
+
+void OpenVRDevice::recordPredictionError()
+{
+    const osg::Timer_t now = osg::Timer::instance()->tick();
+
+    double positionError = 0.0;
+    double angleError = 0.0;
+    unsigned int count = 0;
+    while (!m_predictions.empty() && m_predictions.front().photonTick <= now)
+    {
+        const PosePrediction& prediction = m_predictions.front();
+
+        // The tracked pose when the frame was displayed, looked up after the fact.
+        vr::TrackedDevicePose_t pose;
+        const float secondsAgo = static_cast<float>(osg::Timer::instance()->delta_s(prediction.photonTick, now));
+        if (m_backend->devicePoses(&pose, 1, -secondsAgo) && pose.bPoseIsValid)
+        {
+            OpenVRRigidPose tracked;
+            OpenVRPoseConversion::convert(&pose, 1, &tracked);
+
+            double angle = 0.0;
+            osg::Vec3d axis;
+            (tracked.inverseOrientation * prediction.orientation).getRotate(angle, axis);
+            if (angle > osg::PI)
+            {
+                angle = 2.0 * osg::PI - angle;
+            }
+
+            positionError += (osg::Vec3d(tracked.position) - prediction.position).length() * 1000.0;
+            angleError += osg::RadiansToDegrees(angle);
+            ++count;
+        }
+        m_predictions.pop_front();
+    }
+
+    if (count > 0 && m_stats.valid() && m_stats->collectStats("openvr"))
+    {
+        m_stats->setAttribute(m_frameState.frameNumber, "OpenVR pose error", positionError / count);
+        m_stats->setAttribute(m_frameState.frameNumber, "OpenVR pose error angle", angleError / count);
+    }
+}
+
+void OpenVRDevice::getControllerPose()
+{
+	// The controller list is only copied again after the registry handled a device event.
+	if (m_deviceRegistry.valid() && m_deviceRegistry->revision() != m_controllersRevision)
 	{
-		if (!m_vrSystem->IsTrackedDeviceConnected(unTrackedDevice))
-			continue;
+		m_controllersRevision = m_deviceRegistry->revision();
+		m_deviceRegistry->controllers(m_controllers);
+	}
+	m_iTrackedControllerCount = static_cast<int>(m_controllers.size());
 
-		if (m_vrSystem->GetTrackedDeviceClass(unTrackedDevice) != vr::TrackedDeviceClass_Controller)
-			continue;
+	for (const OpenVRTrackedDevice& controller : m_controllers)
+	{
+		const vr::TrackedDeviceIndex_t unTrackedDevice = controller.index;
 
 		// 判断左右手控制器
-		vr::ETrackedControllerRole controllerRole = m_vrSystem->GetControllerRoleForTrackedDeviceIndex(unTrackedDevice);
-		
-		if (controllerRole == vr::TrackedControllerRole_RightHand)
+		if (controller.role == vr::TrackedControllerRole_RightHand)
 		{
-			if (poses[unTrackedDevice].bPoseIsValid)
+			// Recent poses, velocities and their averages are kept in m_poseHistory[unTrackedDevice].
+			if (m_rigidPoses[unTrackedDevice].valid)
 			{
-				osg::Matrix matrix = convertMatrix34(poses[unTrackedDevice].mDeviceToAbsoluteTracking);
-				osg::Matrix poseTransform = osg::Matrix::inverse(matrix);
-				m_rightControllerPosition = poseTransform.getTrans() * m_worldUnitsPerMetre;
-				m_rightOrientation = poseTransform.getRotate();
-				vr::HmdVector3_t m_rightVelocity = poses[unTrackedDevice].vVelocity;
-				vr::HmdVector3_t m_rightAngularVelocity = poses[unTrackedDevice].vAngularVelocity;
-
-
-				// 存储最近100帧的pose数据
-				if(frameIndex < 100)
-				{
-					controller_poses->push_back(m_rightControllerPosition);
-					frameIndex++;
-				}
-				else
-				{
-					frameIndex = 0;
-					double x_total = 0, y_total = 0, z_total = 0;
-					
-					// 计算当前100帧的平均位置
-					for (uint32_t i = 0;i < controller_poses->getNumElements();i++)
-					{
-						osg::Vec3f pose = controller_poses->at(i);
-						x_total += pose.x();
-						y_total += pose.y();
-						z_total += pose.z();
-						averagePosition.set(x_total/100,y_total/100,z_total/100);
-					}
-				}
+				m_rightControllerPosition = m_rigidPoses[unTrackedDevice].inversePosition * m_worldUnitsPerMetre;
+				m_rightOrientation = m_rigidPoses[unTrackedDevice].inverseOrientation;
 				//std::cout << m_rightControllerPosition.x() << "," << m_rightControllerPosition.y() << "," << m_rightControllerPosition.z() << std::endl;
 
 			}
 		}
-		m_iTrackedControllerCount += 1;
-
-		if (!poses[unTrackedDevice].bPoseIsValid)
-			continue;
-
-
 	}
 }
 
@@ -499,13 +1195,15 @@ osg::Camera* OpenVRDevice::createRTTCamera(OpenVRDevice::Eye eye, osg::Transform
 
     osg::ref_ptr<osg::Camera> camera = new osg::Camera();
     camera->setClearColor(clearColor);
-    camera->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // Cleared by OpenVRDevice::beginEyePass() in the pre draw callback, before the hidden area is masked.
+    camera->setClearMask(0);
     camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
     camera->setRenderOrder(osg::Camera::PRE_RENDER, eye);
     camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
     camera->setAllowEventFocus(false);
     camera->setReferenceFrame(referenceFrame);
-    camera->setViewport(0, 0, buffer->textureWidth(), buffer->textureHeight());
+    // Shared with the eye viewport, follows the resolution scale.
+    camera->setViewport(m_eyeViewport[eye].get());
     camera->setGraphicsContext(gc);
 
     // Here we avoid doing anything regarding OSG camera RTT attachment.
@@ -516,29 +1214,346 @@ osg::Camera* OpenVRDevice::createRTTCamera(OpenVRDevice::Eye eye, osg::Transform
     // would undo our RTT FBO configuration.
     camera->setInitialDrawCallback(new OpenVRInitialDrawCallback());
 
-    camera->setPreDrawCallback(new OpenVRPreDrawCallback(camera.get(), buffer));
+    osg::Uniform* lateLatch = createLateLatchUniform(camera->getOrCreateStateSet());
+
+    // In an eye atlas the left camera starts the shared buffer and the right camera resolves it.
+    const bool atlas = (m_textureBuffer[LEFT] == m_textureBuffer[RIGHT]);
+    camera->setPreDrawCallback(new OpenVRPreDrawCallback(camera.get(), buffer, this, eye, !atlas || eye == LEFT, lateLatch));
+    camera->setFinalDrawCallback(new OpenVRPostDrawCallback(camera.get(), buffer, !atlas || eye == RIGHT));
+
+    return camera.release();
+}
+
+osg::Camera* OpenVRDevice::createSinglePassStereoCamera(osg::Transform::ReferenceFrame referenceFrame, const osg::Vec4& clearColor, osg::GraphicsContext* gc) const
+{
+    OpenVRTextureBuffer* buffer = m_textureBuffer[LEFT];
+
+    osg::ref_ptr<osg::Camera> camera = new osg::Camera();
+    camera->setClearColor(clearColor);
+    camera->setClearMask(0);
+    camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+    camera->setRenderOrder(osg::Camera::PRE_RENDER, LEFT);
+    camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
+    camera->setAllowEventFocus(false);
+    camera->setReferenceFrame(referenceFrame);
+    camera->setViewport(m_stereoViewport.get());
+    camera->setGraphicsContext(gc);
+
+    osg::StateSet* stateSet = camera->getOrCreateStateSet();
+    osg::Uniform* lateLatch = createLateLatchUniform(stateSet);
+
+    // Same FBO handling as the per eye cameras, see createRTTCamera().
+    camera->setInitialDrawCallback(new OpenVRInitialDrawCallback());
+    camera->setPreDrawCallback(new OpenVRPreDrawCallback(camera.get(), buffer, this, COUNT, true, lateLatch));
     camera->setFinalDrawCallback(new OpenVRPostDrawCallback(camera.get(), buffer));
 
+    osg::ref_ptr<osg::Program> program = new osg::Program;
+    program->setName("OpenVRSinglePassStereo");
+    program->addShader(new osg::Shader(osg::Shader::VERTEX, s_singlePassVertexShader));
+    program->addShader(new osg::Shader(osg::Shader::GEOMETRY, s_singlePassGeometryShader));
+    program->addShader(new osg::Shader(osg::Shader::FRAGMENT, s_singlePassFragmentShader));
+    // Scene programs are not stereo aware, so this one has to win.
+    stateSet->setAttributeAndModes(program.get(), osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+    stateSet->setMode(GL_CLIP_DISTANCE0, osg::StateAttribute::ON);
+    stateSet->setMode(GL_CLIP_DISTANCE1, osg::StateAttribute::ON);
+
+    // Eye projections relative to the head camera, i.e. including the eye offset.
+    osg::ref_ptr<osg::Uniform> eyeProjection = new osg::Uniform(osg::Uniform::FLOAT_MAT4, "osgvr_EyeProjection", 2);
+    const osg::Matrix apexToHead = osg::Matrix::inverse(viewMatrixCombined());
+    eyeProjection->setElement(LEFT, osg::Matrixf(apexToHead * viewMatrixLeft() * projectionMatrixLeft()));
+    eyeProjection->setElement(RIGHT, osg::Matrixf(apexToHead * viewMatrixRight() * projectionMatrixRight()));
+    stateSet->addUniform(eyeProjection.get());
+
+    // Untextured geometry samples this white texture, textured geometry overrides it.
+    osg::ref_ptr<osg::Image> white = new osg::Image;
+    white->allocateImage(1, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+    *reinterpret_cast<unsigned int*>(white->data()) = 0xFFFFFFFF;
+    osg::ref_ptr<osg::Texture2D> whiteTexture = new osg::Texture2D(white.get());
+    stateSet->setTextureAttribute(0, whiteTexture.get());
+    stateSet->addUniform(new osg::Uniform("osgvr_Texture0", 0));
+
+    // The defaults of osgUtil::SceneView, lit with a material that follows the vertex colors.
+    stateSet->addUniform(new osg::Uniform("osgvr_Lighting", true));
+    stateSet->addUniform(new osg::Uniform("osgvr_ColorMaterial", true));
+
     return camera.release();
 }
 
+osg::Camera* OpenVRDevice::createSharedCullCamera(osg::Transform::ReferenceFrame referenceFrame, const osg::Vec4& clearColor, osg::GraphicsContext* gc) const
+{
+    osg::ref_ptr<osg::Camera> camera = new osg::Camera();
+    camera->setClearColor(clearColor);
+    camera->setClearMask(0);
+    camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+    camera->setRenderOrder(osg::Camera::PRE_RENDER, LEFT);
+    camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
+    camera->setAllowEventFocus(false);
+    camera->setReferenceFrame(referenceFrame);
+    // Culling only, the render stage draws with the eye viewports.
+    camera->setViewport(m_eyeViewport[LEFT].get());
+    camera->setGraphicsContext(gc);
+
+    // Binding and resolving the eye buffers is done by OpenVRStereoRenderStage for each eye,
+    // so only the normal OSG FBO setup has to be disabled here.
+    camera->setInitialDrawCallback(new OpenVRInitialDrawCallback());
+
+    return camera.release();
+}
+
+void OpenVRDevice::beginEyePass(osg::RenderInfo& renderInfo, OpenVRDevice::Eye eye, const osg::Vec4& clearColor) const
+{
+    osg::State& state = *renderInfo.getState();
+    const osg::Viewport* viewport = m_eyeViewport[eye];
+
+    // Only this eye's region, the single pass buffer holds both eyes.
+    state.applyAttribute(viewport);
+    state.applyMode(GL_SCISSOR_TEST, true);
+    glScissor(static_cast<GLint>(viewport->x()), static_cast<GLint>(viewport->y()),
+              static_cast<GLsizei>(viewport->width()), static_cast<GLsizei>(viewport->height()));
+    state.applyAttribute(m_clearColorMask.get());
+    state.applyAttribute(m_clearDepth.get());
+    glClearColor(clearColor.r(), clearColor.g(), clearColor.b(), clearColor.a());
+    glClearDepth(1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    state.applyMode(GL_SCISSOR_TEST, false);
+
+    if (m_hiddenAreaMaskEnabled && m_hiddenAreaMesh[eye].valid() && !m_hiddenAreaMesh[eye]->empty())
+    {
+        m_hiddenAreaMesh[eye]->draw(renderInfo, viewport);
+    }
+}
+
+void OpenVRDevice::setResolutionScale(float scale)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_frameStateMutex);
+    m_requestedResolutionScale = osg::clampBetween(scale, 0.1f, 1.0f);
+}
+
+void OpenVRDevice::applyResolutionScale(float scale)
+{
+    // The buffers keep their size, only the rendered region of each eye shrinks.
+    const bool sharedBuffer = (m_textureBuffer[LEFT] == m_textureBuffer[RIGHT]);
+    const int fullWidth = sharedBuffer ? m_textureBuffer[LEFT]->textureWidth() / 2 : m_textureBuffer[LEFT]->textureWidth();
+    const int fullHeight = m_textureBuffer[LEFT]->textureHeight();
+    const int width = osg::maximum(1, static_cast<int>(fullWidth * scale + 0.5f));
+    const int height = osg::maximum(1, static_cast<int>(fullHeight * scale + 0.5f));
+
+    m_eyeViewport[LEFT]->setViewport(0, 0, width, height);
+    m_eyeViewport[RIGHT]->setViewport(sharedBuffer ? width : 0, 0, width, height);
+    m_stereoViewport->setViewport(0, 0, 2 * width, height);
+
+    m_textureBuffer[LEFT]->setRenderSize(sharedBuffer ? 2 * width : width, height);
+    m_textureBuffer[RIGHT]->setRenderSize(sharedBuffer ? 2 * width : width, height);
+}
+
+double OpenVRDevice::gpuTimeMs() const
+{
+    if (!m_textureBuffer[LEFT].valid())
+    {
+        return 0.0;
+    }
+
+    double gpuTime = m_textureBuffer[LEFT]->gpuTimeMs();
+    if (m_textureBuffer[RIGHT] != m_textureBuffer[LEFT])
+    {
+        gpuTime += m_textureBuffer[RIGHT]->gpuTimeMs();
+    }
+    return gpuTime;
+}
+
+void OpenVRDevice::updateResolutionScale()
+{
+    if (!m_resolutionGovernor.valid())
+    {
+        return;
+    }
+
+    double gpuTime = gpuTimeMs();
+    bool droppedFrame = false;
+
+    // The record of the last frame stays the same until the next one is presented,
+    // each frame is counted only once.
+    vr::Compositor_FrameTiming timing;
+    if (m_backend->frameTiming(timing) && timing.m_nFrameIndex > m_timedFrameIndex)
+    {
+        m_timedFrameIndex = timing.m_nFrameIndex;
+
+        // Without timer queries use the compositor's measurement of the application's GPU work.
+        if (gpuTime <= 0.0)
+        {
+            gpuTime = timing.m_flTotalRenderGpuMs;
+        }
+        droppedFrame = timing.m_nNumDroppedFrames > 0;
+    }
+
+    const double frameBudgetMs = 1000.0 / m_backend->displayFrequency();
+    setResolutionScale(m_resolutionGovernor->update(gpuTime, frameBudgetMs, droppedFrame));
+}
+
+vr::VRTextureBounds_t OpenVRDevice::textureBounds(OpenVRDevice::Eye eye) const
+{
+    const osg::Viewport* viewport = m_eyeViewport[eye].get();
+    const float width = static_cast<float>(m_textureBuffer[eye]->textureWidth());
+    const float height = static_cast<float>(m_textureBuffer[eye]->textureHeight());
+
+    vr::VRTextureBounds_t bounds;
+    bounds.uMin = viewport->x() / width;
+    bounds.uMax = (viewport->x() + viewport->width()) / width;
+    bounds.vMin = viewport->y() / height;
+    bounds.vMax = (viewport->y() + viewport->height()) / height;
+    return bounds;
+}
+
 bool OpenVRDevice::submitFrame()
 {
     vr::Texture_t leftEyeTexture = {(void*)m_textureBuffer[0]->getTexture(), vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
     vr::Texture_t rightEyeTexture = {(void*)m_textureBuffer[1]->getTexture(), vr::TextureType_OpenGL, vr::ColorSpace_Gamma };
 
-    vr::EVRCompositorError lError = vr::VRCompositor()->Submit(vr::Eye_Left, &leftEyeTexture);
-    vr::EVRCompositorError rError = vr::VRCompositor()->Submit(vr::Eye_Right, &rightEyeTexture);
+    vr::VRTextureBounds_t leftBounds = textureBounds(LEFT);
+    vr::VRTextureBounds_t rightBounds = textureBounds(RIGHT);
+
+    bool lSubmitted = m_backend->submit(vr::Eye_Left, leftEyeTexture, &leftBounds);
+    bool rSubmitted = m_backend->submit(vr::Eye_Right, rightEyeTexture, &rightBounds);
+
+    // The poses for the next frame can be waited for from now on.
+    if (m_poseService.valid())
+    {
+        m_poseService->frameSubmitted();
+    }
+
+    m_textureBuffer[LEFT]->onSubmitted();
+    if (m_textureBuffer[RIGHT] != m_textureBuffer[LEFT])
+    {
+        m_textureBuffer[RIGHT]->onSubmitted();
+    }
 
-    return lError == vr::VRCompositorError_None && rError == vr::VRCompositorError_None;
+    return lSubmitted && rSubmitted;
 }
 
-void OpenVRDevice::blitMirrorTexture(osg::GraphicsContext* gc)
+unsigned int OpenVRDevice::takeGLCallCount()
 {
-    m_mirrorTexture->blitTexture(gc, m_textureBuffer[0], m_textureBuffer[1]);
+    unsigned int calls = 0;
+    if (m_textureBuffer[LEFT].valid())
+    {
+        calls += m_textureBuffer[LEFT]->takeGLCallCount();
+    }
+    if (m_textureBuffer[RIGHT].valid() && m_textureBuffer[RIGHT] != m_textureBuffer[LEFT])
+    {
+        calls += m_textureBuffer[RIGHT]->takeGLCallCount();
+    }
+    if (m_mirrorTexture.valid())
+    {
+        calls += m_mirrorTexture->takeGLCallCount();
+    }
+    return calls;
 }
 
-osg::GraphicsContext::Traits* OpenVRDevice::graphicsContextTraits() const
+void OpenVRDevice::captureFrame(osg::GraphicsContext* gc)
+{
+    if (!m_frameCapture.valid())
+    {
+        return;
+    }
+
+    // The left and right eye regions are stored side by side, an eye atlas is read at once.
+    OpenVRFrameCapture::Region regions[2];
+    unsigned int regionCount = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        const osg::Viewport* rect = m_eyeViewport[i].get();
+        OpenVRFrameCapture::Region region = { m_textureBuffer[i]->resolveFramebuffer(),
+                                              static_cast<GLint>(rect->x()), static_cast<GLint>(rect->y()),
+                                              static_cast<GLint>(rect->width()), static_cast<GLint>(rect->height()) };
+        if (regionCount > 0 && region.framebuffer == regions[0].framebuffer &&
+            region.x == regions[0].x + regions[0].width && region.y == regions[0].y)
+        {
+            regions[0].width += region.width;
+            continue;
+        }
+        regions[regionCount++] = region;
+    }
+
+    m_frameCapture->capture(*gc->getState(), regions, regionCount, drawFrameState().frameNumber);
+}
+
+void OpenVRDevice::recordFrameTiming(unsigned int frameNumber)
+{
+    // Taken every frame so the count always covers a single frame.
+    const unsigned int glCalls = takeGLCallCount();
+
+    if (!m_stats.valid() || !m_stats->collectStats("openvr"))
+    {
+        return;
+    }
+
+    m_stats->setAttribute(frameNumber, "OpenVR GL calls", glCalls);
+    if (m_frameCapture.valid())
+    {
+        m_stats->setAttribute(frameNumber, "OpenVR capture rate", m_frameCapture->captureRate());
+        m_stats->setAttribute(frameNumber, "OpenVR capture queue", m_frameCapture->queueDepth());
+        m_stats->setAttribute(frameNumber, "OpenVR capture dropped", m_frameCapture->droppedFrames());
+    }
+
+    double hiddenArea = 0.0;
+    if (m_hiddenAreaMaskEnabled && m_hiddenAreaMesh[LEFT].valid() && m_hiddenAreaMesh[RIGHT].valid())
+    {
+        hiddenArea = 50.0 * (m_hiddenAreaMesh[LEFT]->coverage() + m_hiddenAreaMesh[RIGHT]->coverage());
+    }
+    m_stats->setAttribute(frameNumber, "OpenVR hidden area masked", hiddenArea);
+    m_stats->setAttribute(frameNumber, "OpenVR eye GPU", gpuTimeMs());
+    m_stats->setAttribute(frameNumber, "OpenVR resolution scale", drawFrameState().resolutionScale);
+    if (m_textureBuffer[LEFT].valid())
+    {
+        double stall = m_textureBuffer[LEFT]->resolveStallMs();
+        if (m_textureBuffer[RIGHT] != m_textureBuffer[LEFT])
+        {
+            stall += m_textureBuffer[RIGHT]->resolveStallMs();
+        }
+        m_stats->setAttribute(frameNumber, "OpenVR resolve stall", stall);
+    }
+
+    vr::Compositor_FrameTiming timing;
+    if (!m_backend->frameTiming(timing))
+    {
+        return;
+    }
+
+    m_stats->setAttribute(frameNumber, "OpenVR frame interval", timing.m_flClientFrameIntervalMs);
+    m_stats->setAttribute(frameNumber, "OpenVR submit", timing.m_flSubmitFrameMs);
+    m_stats->setAttribute(frameNumber, "OpenVR render GPU", timing.m_flTotalRenderGpuMs);
+    m_stats->setAttribute(frameNumber, "OpenVR dropped frames", timing.m_nNumDroppedFrames);
+}
+
+bool OpenVRDevice::blitMirrorTexture(osg::GraphicsContext* gc)
+{
+    if (m_mirrorMode == MIRROR_OFF || (m_mirrorFrame++ % m_mirrorInterval) != 0)
+    {
+        return false;
+    }
+
+    // The compositor mirror can fail temporarily, the eye buffers are shown until it is tried again.
+    if (m_mirrorMode == MIRROR_COMPOSITOR && m_mirrorFrame >= m_compositorMirrorRetryFrame)
+    {
+        if (m_mirrorTexture->blitCompositorTexture(gc))
+        {
+            m_compositorMirrorRetryFrame = 0;
+            return true;
+        }
+        if (m_compositorMirrorRetryFrame == 0)
+        {
+            osg::notify(osg::WARN) << "Warning: Compositor mirror texture not available, mirroring the eye buffers." << std::endl;
+        }
+        m_compositorMirrorRetryFrame = m_mirrorFrame + s_compositorMirrorRetryFrames;
+    }
+
+    const MirrorMode mode = (m_mirrorMode == MIRROR_COMPOSITOR) ? MIRROR_BOTH : m_mirrorMode;
+    OpenVRTextureBuffer* left = mode != MIRROR_RIGHT ? m_textureBuffer[LEFT].get() : nullptr;
+    OpenVRTextureBuffer* right = mode != MIRROR_LEFT ? m_textureBuffer[RIGHT].get() : nullptr;
+    m_mirrorTexture->blitTexture(gc, left, m_eyeViewport[LEFT], right, m_eyeViewport[RIGHT]);
+    return true;
+}
+
+osg::GraphicsContext::Traits* OpenVRDevice::graphicsContextTraits(bool pbuffer)
 {
     osg::GraphicsContext::WindowingSystemInterface* wsi = osg::GraphicsContext::getWindowingSystemInterface();
 
@@ -566,8 +1581,11 @@ osg::GraphicsContext::Traits* OpenVRDevice::graphicsContextTraits() const
         osg::notify(osg::INFO) << "Couldn't get screen number, setting to 0" << std::endl;
     }
 
-    unsigned int width, height;
-    wsi->getScreenResolution(si, width, height);
+    if (!pbuffer)
+    {
+        unsigned int width, height;
+        wsi->getScreenResolution(si, width, height);
+    }
 
     osg::ref_ptr<osg::GraphicsContext::Traits> traits = new osg::GraphicsContext::Traits;
     traits->hostName = si.hostName;
@@ -582,11 +1600,27 @@ osg::GraphicsContext::Traits* OpenVRDevice::graphicsContextTraits() const
     traits->sharedContext = nullptr;
     traits->vsync = false; // VSync should always be disabled for because HMD submit handles the timing of the swap.
 
+    if (pbuffer)
+    {
+        // Offscreen surface, the eye buffers are FBOs anyway and only the mirror would be lost.
+        traits->pbuffer = true;
+        traits->windowDecoration = false;
+        traits->doubleBuffer = false;
+        traits->x = 0;
+        traits->y = 0;
+    }
+
     return traits.release();
 }
 
 void OpenVRDevice::shutdown(osg::GraphicsContext* gc)
 {
+    // Flush the capture while the eye buffers it reads still exist
+    if (m_frameCapture.valid())
+    {
+        m_frameCapture->destroy(*gc->getState());
+    }
+
     // Delete mirror texture
     if (m_mirrorTexture.valid())
     {
@@ -594,7 +1628,20 @@ void OpenVRDevice::shutdown(osg::GraphicsContext* gc)
         m_mirrorTexture = nullptr;
     }
 
-    // Delete texture and depth buffers
+    for (int eye = LEFT; eye < COUNT; ++eye)
+    {
+        if (m_hiddenAreaMesh[eye].valid())
+        {
+            m_hiddenAreaMesh[eye]->releaseGLObjects(gc->getState());
+        }
+    }
+
+    // Delete texture and depth buffers, in single pass mode both eyes share one buffer
+    if (m_textureBuffer[RIGHT] == m_textureBuffer[LEFT])
+    {
+        m_textureBuffer[RIGHT] = nullptr;
+    }
+
     for (int i = 0; i < 2; i++)
     {
         if (m_textureBuffer[i].valid())
@@ -604,10 +1651,17 @@ void OpenVRDevice::shutdown(osg::GraphicsContext* gc)
         }
     }
 
-    if (m_vrSystem != nullptr)
+    // The pose thread may be waiting in the backend
+    if (m_poseService.valid())
+    {
+        m_poseService->stop();
+        m_poseService = nullptr;
+    }
+
+    if (m_backend.valid())
     {
-        vr::VR_Shutdown();
-        m_vrSystem = nullptr;
+        m_backend->shutdown();
+        m_backend = nullptr;
     }
 
 }
@@ -617,83 +1671,63 @@ void OpenVRDevice::shutdown(osg::GraphicsContext* gc)
 //-----------------------------------------------------------------------------
 void OpenVRDevice::ProcessVREvent(const vr::VREvent_t& event)
 {
+	// Device events update the registry, the role of the event's device is taken from it.
+	if (m_deviceRegistry.valid())
+	{
+		m_deviceRegistry->processEvent(event);
+	}
 
-
-	vr::ETrackedControllerRole controllerRole = m_vrSystem->GetControllerRoleForTrackedDeviceIndex(event.trackedDeviceIndex);
-	prevState = state;
-
-	m_vrSystem->GetControllerState(event.trackedDeviceIndex, &state, sizeof(state));
-
+	OpenVRControllerEvent controllerEvent;
 	switch (event.eventType)
 	{
 	case vr::VREvent_TrackedDeviceActivated:
 	{
 		printf("Device %u attached. Setting up render model.\n", event.trackedDeviceIndex);
+		return;
 	}
-	break;
 	case vr::VREvent_TrackedDeviceDeactivated:
 	{
 		printf("Device %u detached.\n", event.trackedDeviceIndex);
+		return;
 	}
-	break;
 	case vr::VREvent_TrackedDeviceUpdated:
 	{
 		printf("Device %u updated.\n", event.trackedDeviceIndex);
+		return;
 	}
-	break;
 	case vr::VREvent_ButtonPress:
-	{
+		controllerEvent.type = OpenVRControllerEvent::BUTTON_PRESS;
+		break;
+	case vr::VREvent_ButtonUnpress:
+		controllerEvent.type = OpenVRControllerEvent::BUTTON_UNPRESS;
+		break;
+	case vr::VREvent_ButtonTouch:
+		controllerEvent.type = OpenVRControllerEvent::BUTTON_TOUCH;
+		break;
+	case vr::VREvent_ButtonUntouch:
+		controllerEvent.type = OpenVRControllerEvent::BUTTON_UNTOUCH;
+		break;
+	default:
+		return;
+	}
 
-		// 缩放 touchpad 按下上下位置
-		// 使用touchpad 左右位置 进行 左右 旋转操作
-		// 直接返回touchpad的坐标
-		if (event.data.controller.button == vr::k_EButton_SteamVR_Touchpad)
-		{
-			m_vrSystem->GetControllerState(event.trackedDeviceIndex, &state, sizeof(state));
-			if (m_touchpadPreTouchPosition.x() != state.rAxis->x || m_touchpadPreTouchPosition.y() != state.rAxis->y)
-			{
-				m_touchpadPreTouchPosition.set(m_touchpadTouchPosition.x(), m_touchpadTouchPosition.y());
-				m_touchpadTouchPosition.set(state.rAxis->x, state.rAxis->y);
-				printf("touchPad previous position %d,%d", m_touchpadPreTouchPosition.x(), m_touchpadPreTouchPosition.y());
-			}
-			controllerEventResult = OpenVRDevice::Touchpad_Press;
-		}
-		/*else if (event.data.controller.button == vr::k_EButton_Grip)
-		{
-			controllerEventResult = 6;
-		}*/
-		else if (event.data.controller.button == vr::EVRButtonId::k_EButton_SteamVR_Trigger)
-		{
-			// 主要用右手
-			if (controllerRole == vr::TrackedControllerRole_RightHand)
-			{
-				controllerEventResult = Trigger_Press;
-			}
+	// Only controller button events get this far, their state is needed for the axes.
+	controllerEvent.device = event.trackedDeviceIndex;
+	controllerEvent.role = m_deviceRegistry.valid() ? m_deviceRegistry->controllerRole(event.trackedDeviceIndex) : vr::TrackedControllerRole_Invalid;
+	controllerEvent.button = static_cast<vr::EVRButtonId>(event.data.controller.button);
+	controllerEvent.tick = osg::Timer::instance()->tick() - static_cast<osg::Timer_t>(event.eventAgeSeconds / osg::Timer::instance()->getSecondsPerTick());
 
-		}
-	}
-	break;
-	// 直到按键弹起后，其他按键才有效
-	case vr::VREvent_ButtonUnpress:
+	vr::VRControllerState_t state;
+	if (m_backend->controllerState(event.trackedDeviceIndex, state))
 	{
-		// 右手
-		if (controllerRole == vr::TrackedControllerRole_RightHand)
+		for (uint32_t i = 0; i < vr::k_unControllerStateAxisCount; ++i)
 		{
-			// touchpad 松开，旋转结束
-			if (event.data.controller.button == vr::k_EButton_SteamVR_Touchpad)
-			{
-				printf("TrackedControllerRole_RightHand unpress.\n", event.trackedDeviceIndex);
-
-				controllerEventResult = OpenVRDevice::Touchpad_Unpress;
-			}
-			else if (event.data.controller.button == vr::k_EButton_SteamVR_Trigger)
-			{
-				controllerEventResult = OpenVRDevice::Trigger_Unpress;
-			}
+			controllerEvent.axis[i].set(state.rAxis[i].x, state.rAxis[i].y);
 		}
 	}
-	break;
-	}
+
+	// HandleInput() only polls while there is room, so this does not fail.
+	m_controllerEvents.push(controllerEvent);
 }
 
 //-----------------------------------------------------------------------------
@@ -701,9 +1735,10 @@ void OpenVRDevice::ProcessVREvent(const vr::VREvent_t& event)
 //-----------------------------------------------------------------------------
 void OpenVRDevice::HandleInput()
 {
-	// Process SteamVR events
+	// Process SteamVR events. Once the controller event queue is full the remaining
+	// events stay queued in the runtime until the next frame, so none are lost.
 	vr::VREvent_t event;
-	while (m_vrSystem->PollNextEvent(&event, sizeof(event)))
+	while (!m_controllerEvents.full() && m_backend->pollNextEvent(event))
 	{
 		ProcessVREvent(event);
 	}
@@ -719,9 +1754,9 @@ void OpenVRDevice::calculateEyeAdjustment()
 {
     vr::HmdMatrix34_t mat;
     
-    mat = m_vrSystem->GetEyeToHeadTransform(vr::Eye_Left);
+    mat = m_backend->eyeToHeadTransform(vr::Eye_Left);
     m_leftEyeAdjust = convertMatrix34(mat).getTrans();
-    mat = m_vrSystem->GetEyeToHeadTransform(vr::Eye_Right);
+    mat = m_backend->eyeToHeadTransform(vr::Eye_Right);
     m_rightEyeAdjust = convertMatrix34(mat).getTrans();
     
     // Display IPD
@@ -737,13 +1772,47 @@ void OpenVRDevice::calculateProjectionMatrices()
 {
     vr::HmdMatrix44_t mat;
     
-    mat = m_vrSystem->GetProjectionMatrix(vr::Eye_Left, m_nearClip, m_farClip);
+    mat = m_backend->projectionMatrix(vr::Eye_Left, m_nearClip, m_farClip);
     m_leftEyeProjectionMatrix = convertMatrix44(mat);
 
-    mat = m_vrSystem->GetProjectionMatrix(vr::Eye_Right, m_nearClip, m_farClip);
+    mat = m_backend->projectionMatrix(vr::Eye_Right, m_nearClip, m_farClip);
     m_rightEyeProjectionMatrix = convertMatrix44(mat);
 }
 
+void OpenVRDevice::calculateCombinedFrustum()
+{
+    // Frustum edges of both eyes as tangents, positive away from the view axis.
+    double left[2], right[2], bottom[2], top[2], zNear, zFar;
+    osg::Matrix(m_leftEyeProjectionMatrix).getFrustum(left[LEFT], right[LEFT], bottom[LEFT], top[LEFT], zNear, zFar);
+    osg::Matrix(m_rightEyeProjectionMatrix).getFrustum(left[RIGHT], right[RIGHT], bottom[RIGHT], top[RIGHT], zNear, zFar);
+
+    const double tanLeft = -osg::minimum(left[LEFT], left[RIGHT]) / zNear;
+    const double tanRight = osg::maximum(right[LEFT], right[RIGHT]) / zNear;
+    const double tanBottom = -osg::minimum(bottom[LEFT], bottom[RIGHT]) / zNear;
+    const double tanTop = osg::maximum(top[LEFT], top[RIGHT]) / zNear;
+
+    // Move the apex back until the widest edges pass through the outermost eye positions,
+    // then the combined frustum contains both eye frustums.
+    const double minX = osg::minimum(m_leftEyeAdjust.x(), m_rightEyeAdjust.x());
+    const double maxX = osg::maximum(m_leftEyeAdjust.x(), m_rightEyeAdjust.x());
+    const double minY = osg::minimum(m_leftEyeAdjust.y(), m_rightEyeAdjust.y());
+    const double maxY = osg::maximum(m_leftEyeAdjust.y(), m_rightEyeAdjust.y());
+
+    const double recessX = (maxX - minX) / (tanLeft + tanRight);
+    const double recessY = (maxY - minY) / (tanBottom + tanTop);
+    const double recess = osg::maximum(recessX, recessY);
+
+    m_combinedApex.set(minX + tanLeft * recessX,
+                       minY + tanBottom * recessY,
+                       0.5 * (m_leftEyeAdjust.z() + m_rightEyeAdjust.z()) + recess);
+
+    const double combinedNear = m_nearClip + recess;
+    const double combinedFar = m_farClip + recess;
+    m_combinedProjectionMatrix.makeFrustum(-tanLeft * combinedNear, tanRight * combinedNear,
+                                           -tanBottom * combinedNear, tanTop * combinedNear,
+                                           combinedNear, combinedFar);
+}
+
 void OpenVRDevice::trySetProcessAsHighPriority() const
 {
     // Require at least 4 processors, otherwise the process could occupy the machine.
@@ -783,16 +1852,27 @@ void OpenVRSwapCallback::swapBuffersImplementation(osg::GraphicsContext* gc)
     // Submit rendered frame to compositor
     m_device->submitFrame();
 
-    // Blit mirror texture to backbuffer
-    m_device->blitMirrorTexture(gc);
+    // Queue the readback of the submitted images, only after the submit so it does not delay it
+    m_device->captureFrame(gc);
 
-    // Run the default system swapBufferImplementation
-    gc->swapBuffersImplementation();
-
-    // Update poses from HMD
-    m_device->updatePose();
+    // Blit mirror texture to backbuffer. Nothing else draws into the window, so when the
+    // mirror is skipped the swap is skipped too and the window keeps its last image.
+    if (m_device->blitMirrorTexture(gc))
+    {
+        // Run the default system swapBufferImplementation
+        gc->swapBuffersImplementation();
+    }
 
+    // The poses are received on the pose thread and taken by the next beginFrame().
 	m_device->HandleInput();
+
+    // Compositor timing of a frame is complete once the poses after it have been received on
+    // the pose thread, so the latest timing may still be that of the frame before this one.
+    m_device->updateResolutionScale();
+    m_device->recordFrameTiming(m_device->drawFrameState().frameNumber);
+
+    // The next frame may now change the state shared with the cameras.
+    m_device->endDrawFrame();
 }
 
 
@@ -12,68 +12,175 @@
 #include <openvr.h>
 
 #include <osg/Geode>
+#include <osg/Geometry>
 #include <osg/Texture2D>
 #include <osg/Version>
 #include <osg/FrameBufferObject>
 #include <osgViewer/Renderer>
 #include <osg/Program>
 #include <osg/Shader>  
+#include <osg/Stats>
+#include <osg/Viewport>
+#include <osg/Depth>
+#include <osg/ColorMask>
+#include <osg/Uniform>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
 #include <array>
+#include <deque>
+#include <vector>
+
+#include "openvrbackend.h"
+#include "openvrresolutiongovernor.h"
+#include "openvrframecapture.h"
+#include "openvrposeservice.h"
+#include "openvrdeviceregistry.h"
+#include "openvrposeconversion.h"
+#include "openvrposehistory.h"
+#include "openvrcontrollerevents.h"
 
 
 #if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
     typedef osg::GLExtensions OSG_GLExtensions;
     typedef osg::GLExtensions OSG_Texture_Extensions;
+    typedef osg::GLExtensions OSG_Query_Extensions;
 #else
     typedef osg::FBOExtensions OSG_GLExtensions;
     typedef osg::Texture::Extensions OSG_Texture_Extensions;
+    typedef osg::Drawable::Extensions OSG_Query_Extensions;
 #endif
 
 
 static bool g_bPrintf = true;
 
+// GL 3.2 sync objects and GL 4.3 framebuffer invalidation, not wrapped by all OSG versions supported here.
+typedef struct __GLsync* OpenVRGLsync;
+struct OpenVRExtensions
+{
+    OpenVRExtensions();
+    bool syncAvailable() const { return glFenceSync != nullptr && glClientWaitSync != nullptr && glDeleteSync != nullptr; }
+
+    OpenVRGLsync (GL_APIENTRY * glFenceSync)(GLenum condition, GLbitfield flags);
+    GLenum (GL_APIENTRY * glClientWaitSync)(OpenVRGLsync sync, GLbitfield flags, uint64_t timeout);
+    void (GL_APIENTRY * glDeleteSync)(OpenVRGLsync sync);
+    void (GL_APIENTRY * glInvalidateFramebuffer)(GLenum target, GLsizei numAttachments, const GLenum* attachments); // optional
+};
+
 class OpenVRTextureBuffer : public osg::Referenced
 {
 public:
-    OpenVRTextureBuffer(osg::ref_ptr<osg::State> state, int width, int height, int msaaSamples);
+    // resolveBuffers > 1 creates a ring of resolve textures, so the next frame can be
+    // resolved while the compositor still reads the previous ones.
+    OpenVRTextureBuffer(osg::ref_ptr<osg::State> state, int width, int height, int msaaSamples, int resolveBuffers = 1);
     void destroy(osg::GraphicsContext* gc);
-    GLuint getTexture() { return m_Resolve_ColorTex; }
+    GLuint getTexture() { return m_Resolve_ColorTex[m_resolveIndex]; }
+    GLuint resolveFramebuffer() const { return m_Resolve_FBO[m_resolveIndex]; } // FBO of getTexture()
     int textureWidth() const { return m_width; }
     int textureHeight() const { return m_height; }
     int samples() const { return m_samples; }
     void onPreRender(osg::RenderInfo& renderInfo);
     void onPostRender(osg::RenderInfo& renderInfo);
+    // Binds the MSAA FBO again without starting a new frame, for the second eye of an atlas.
+    void bind(osg::RenderInfo& renderInfo);
+
+    // Part of the texture rendered to, starting at the origin. Only this part is resolved.
+    void setRenderSize(int width, int height);
+
+    // GPU time between onPreRender and onPostRender of a recent frame, 0 without timer queries.
+    double gpuTimeMs() const { return m_gpuTimeMs; }
+
+    // Called after the texture returned by getTexture() has been submitted.
+    void onSubmitted();
+    int resolveBufferCount() const { return static_cast<int>(m_Resolve_ColorTex.size()); }
+    // Time the last resolve waited for the compositor to release a resolve texture.
+    double resolveStallMs() const { return m_resolveStallMs; }
+
+    // Number of GL calls made by the buffer since the last call, to track per frame overhead.
+    unsigned int takeGLCallCount();
 
 protected:
     ~OpenVRTextureBuffer() {}
 
     friend class OpenVRMirrorTexture;
-    GLuint m_Resolve_FBO; // MSAA FBO is copied to this FBO after render.
-    GLuint m_Resolve_ColorTex; // color texture for above FBO.
+    std::vector<GLuint> m_Resolve_FBO; // MSAA FBO is copied to these FBOs after render, one per texture.
+    std::vector<GLuint> m_Resolve_ColorTex; // ring of color textures attached to above FBOs.
+    std::vector<OpenVRGLsync> m_Resolve_Fence; // signaled when the submit of the texture has completed
+    int m_resolveIndex; // texture of the last resolve
+    double m_resolveStallMs;
+    OpenVRExtensions m_glExt;
     GLuint m_MSAA_FBO; // framebuffer for MSAA RTT
     GLuint m_MSAA_ColorTex; // color texture for MSAA RTT 
     GLuint m_MSAA_DepthTex; // depth texture for MSAA RTT
     GLint m_width; // width of texture in pixels
     GLint m_height; // height of texture in pixels
+    GLint m_renderWidth; // width of the rendered region
+    GLint m_renderHeight; // height of the rendered region
     int m_samples;  // sample width for MSAA
 
+    static const int TIMER_QUERY_COUNT = 4;
+    GLuint m_timerQuery[TIMER_QUERY_COUNT]; // GL_TIME_ELAPSED queries, 0 if unsupported
+    int m_timerQueryIndex;
+    double m_gpuTimeMs;
+    unsigned int m_glCalls;
+
 };
 
+// Copies the eye images, or the compositor's own mirror textures, into the back buffer
+// of the window, scaled to the current window size.
 class OpenVRMirrorTexture : public osg::Referenced
 {
 public:
-    OpenVRMirrorTexture(osg::ref_ptr<osg::State> state, GLint width, GLint height);
+    explicit OpenVRMirrorTexture(OpenVRBackend* backend);
     void destroy(osg::GraphicsContext* gc);
-    void blitTexture(osg::GraphicsContext* gc, OpenVRTextureBuffer* leftEye,  OpenVRTextureBuffer* rightEye);
+    // With one of the eye buffers null the other eye fills the whole window.
+    void blitTexture(osg::GraphicsContext* gc, OpenVRTextureBuffer* leftEye, const osg::Viewport* leftRect,
+                     OpenVRTextureBuffer* rightEye, const osg::Viewport* rightRect);
+    // Both eyes as displayed by the compositor, false if the backend does not provide them.
+    bool blitCompositorTexture(osg::GraphicsContext* gc);
+    unsigned int takeGLCallCount();
 protected:
     ~OpenVRMirrorTexture() {}
 
-    GLuint m_mirrorFBO;
-    GLuint m_mirrorTex;
-    GLint m_width;
-    GLint m_height;
+    bool acquireCompositorTextures(osg::GraphicsContext* gc);
+    void releaseCompositorTextures();
+    void copyToWindow(const OSG_GLExtensions* fbo_ext, GLuint readFBO, double x, double y, double width, double height,
+                      GLint windowX0, GLint windowX1, GLint windowHeight);
+
+    osg::ref_ptr<OpenVRBackend> m_backend;
+    GLuint m_compositorFBO[2]; // read FBOs with the compositor mirror textures attached
+    vr::glUInt_t m_compositorTex[2];
+    vr::glSharedTextureHandle_t m_compositorHandle[2];
+    GLint m_compositorWidth;
+    GLint m_compositorHeight;
+    bool m_compositorAcquired;
+    unsigned int m_glCalls;
+};
+
+// Triangles of the render target area of one eye that is not visible through the lens,
+// in texture coordinates of the eye's viewport. They are drawn at the near plane after
+// the eye buffer is cleared, so the depth test rejects the scene fragments behind them.
+// The triangles are kept in a vertex buffer object created with the first draw.
+class OpenVRHiddenAreaMesh : public osg::Referenced
+{
+public:
+    explicit OpenVRHiddenAreaMesh(const vr::HiddenAreaMesh_t& mesh);
+    void draw(osg::RenderInfo& renderInfo, const osg::Viewport* viewport) const;
+    void releaseGLObjects(osg::State* state) const { m_geometry->releaseGLObjects(state); }
+    bool empty() const { return m_geometry->getVertexArray()->getNumElements() == 0; }
+    float coverage() const { return m_coverage; } // fraction of the eye's pixels covered
+protected:
+    ~OpenVRHiddenAreaMesh() {}
+
+    osg::ref_ptr<osg::Geometry> m_geometry; // in clip coordinates at the near plane
+    float m_coverage;
+    osg::ref_ptr<osg::RefMatrix> m_identity;
+    osg::ref_ptr<osg::Depth> m_depth;
+    osg::ref_ptr<osg::ColorMask> m_colorMask;
+    osg::ref_ptr<osg::Program> m_program;
 };
 
+class OpenVRDevice;
+
 class OpenVRInitialDrawCallback : public osg::Camera::DrawCallback
 {
 public:
@@ -92,9 +199,16 @@ public:
 class OpenVRPreDrawCallback : public osg::Camera::DrawCallback
 {
 public:
-    OpenVRPreDrawCallback(osg::Camera* camera, OpenVRTextureBuffer* textureBuffer)
+    // eye is an OpenVRDevice::Eye, or OpenVRDevice::COUNT when the buffer holds both eyes.
+    // startBuffer is false for the second camera drawing into an eye atlas, it only rebinds the buffer.
+    // lateLatch, when given, is set to the camera's late latch correction before each draw.
+    OpenVRPreDrawCallback(osg::Camera* camera, OpenVRTextureBuffer* textureBuffer, const OpenVRDevice* device, int eye, bool startBuffer = true, osg::Uniform* lateLatch = nullptr)
         : m_camera(camera)
         , m_textureBuffer(textureBuffer)
+        , m_device(device)
+        , m_eye(eye)
+        , m_startBuffer(startBuffer)
+        , m_lateLatch(lateLatch)
     {
     }
 
@@ -102,15 +216,21 @@ public:
 protected:
     osg::Camera* m_camera;
     OpenVRTextureBuffer* m_textureBuffer;
+    const OpenVRDevice* m_device;
+    int m_eye;
+    bool m_startBuffer;
+    osg::ref_ptr<osg::Uniform> m_lateLatch;
 
 };
 
 class OpenVRPostDrawCallback : public osg::Camera::DrawCallback
 {
 public:
-    OpenVRPostDrawCallback(osg::Camera* camera, OpenVRTextureBuffer* textureBuffer)
+    // resolve is false for the first camera drawing into an eye atlas, the second one resolves both eyes.
+    OpenVRPostDrawCallback(osg::Camera* camera, OpenVRTextureBuffer* textureBuffer, bool resolve = true)
         : m_camera(camera)
         , m_textureBuffer(textureBuffer)
+        , m_resolve(resolve)
     {
     }
 
@@ -118,9 +238,24 @@ public:
 protected:
     osg::Camera* m_camera;
     OpenVRTextureBuffer* m_textureBuffer;
+    bool m_resolve;
 
 };
 
+// Per frame values that the update traversal hands to the draw of the same frame.
+// With DrawThreadPerContext the next frame is updated and culled while this one is
+// drawn, so the draw side must not read the values the update side is changing.
+struct OpenVRFrameState
+{
+    OpenVRFrameState() : frameNumber(0), resolutionScale(1.0f) {}
+
+    unsigned int frameNumber;
+    OpenVRPoseSnapshot poses; // tracked device poses the frame was updated with
+    // The head pose below is either that of the snapshot, or predicted for the display of the frame.
+    osg::Vec3 position;    // head pose the eye views of the frame were culled with
+    osg::Quat orientation;
+    float resolutionScale;
+};
 
 class OpenVRDevice : public osg::Referenced
 {
@@ -133,34 +268,66 @@ public:
         COUNT = 2
     } Eye;
 
-	static typedef enum Action_
-	{
-		Touchpad_Press = 0,
-		Touchpad_Unpress= 1,
-		Trigger_Press = 2,
-		Trigger_Unpress = 3,
+    typedef enum StereoMode_
+    {
+        MULTI_PASS = 0,  // one RTT camera, cull and draw per eye
+        SINGLE_PASS = 1, // both eyes drawn in one pass into a side-by-side texture
+        SHARED_CULL = 2  // one cull with the combined frustum, drawn once per eye
+    } StereoMode;
 
+    typedef enum MirrorMode_
+    {
+        MIRROR_OFF = 0,       // the window is not updated
+        MIRROR_LEFT = 1,      // left eye buffer
+        MIRROR_RIGHT = 2,     // right eye buffer
+        MIRROR_BOTH = 3,      // both eye buffers side by side
+        MIRROR_COMPOSITOR = 4 // both eyes as displayed by the compositor
+    } MirrorMode;
 
-	} Action;
 	// VR ģ
 	bool m_rbShowTrackedDevice[vr::k_unMaxTrackedDeviceCount];
 	int m_iTrackedControllerCount;
-	vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
     OpenVRDevice(float nearClip, float farClip, const float worldUnitsPerMetre = 1.0f, const int samples = 0);
+    OpenVRDevice(osg::ref_ptr<OpenVRBackend> backend, float nearClip, float farClip, const float worldUnitsPerMetre = 1.0f, const int samples = 0);
     void createRenderBuffers(osg::ref_ptr<osg::State> state);
+    // Queries projections and hidden area meshes and starts the pose service. Does not need a
+    // graphics context, so it can run while the window is created; otherwise it runs at realize.
     void init();
+    // Deletes the GL objects, gc has to be current on the calling thread.
     void shutdown(osg::GraphicsContext* gc);
 
 	void ProcessVREvent(const vr::VREvent_t& event);
 	void HandleInput();
+	// Button events of the controllers in the order they happened, for a single consuming thread.
+	// Returns false when there is none left.
+	bool nextControllerEvent(OpenVRControllerEvent& event) { return m_controllerEvents.pop(event); }
 
     static bool hmdPresent();
     bool hmdInitialized() const;
 
+    OpenVRBackend* backend() const { return m_backend.get(); }
+    float worldUnitsPerMetre() const { return m_worldUnitsPerMetre; }
+    // Tracked devices and their properties, available once init() has been called.
+    OpenVRDeviceRegistry* deviceRegistry() const { return m_deviceRegistry.get(); }
+    // Recent tracking space poses of a device, one per pose snapshot. Only for the update thread.
+    const OpenVRPoseHistory& poseHistory(vr::TrackedDeviceIndex_t index) const { return m_poseHistory[index]; }
+
+    // Per frame timing is recorded as "OpenVR ..." attributes when stats->collectStats("openvr") is enabled.
+    void setStats(osg::Stats* stats) { m_stats = stats; }
+    void recordFrameTiming(unsigned int frameNumber);
+
+    // GL calls made by the texture buffers and the mirror since the last call.
+    unsigned int takeGLCallCount();
+
     osg::Matrix projectionMatrixCenter() const;
     osg::Matrix projectionMatrixLeft() const;
     osg::Matrix projectionMatrixRight() const;
 
+    // Conservative frustum enclosing both eye frustums. Its apex lies behind the eyes,
+    // viewMatrixCombined() is the offset from the head to that apex.
+    osg::Matrix projectionMatrixCombined() const;
+    osg::Matrix viewMatrixCombined() const;
+
     osg::Matrix projectionOffsetMatrixLeft() const;
     osg::Matrix projectionOffsetMatrixRight() const;
 
@@ -171,24 +338,110 @@ public:
     float farClip() const { return m_farClip; }
 
     void resetSensorOrientation() const;
-    void updatePose();
 	void getControllerPose();
 
-    osg::Vec3 position() const { return m_position; }
-    osg::Quat orientation() const { return m_orientation;  }
+    // Head pose of the frame being updated, the same as in frameState(). Only for the update/cull thread.
+    osg::Vec3 position() const { return m_frameState.position; }
+    osg::Quat orientation() const { return m_frameState.orientation; }
+
+    // View offset of a slave camera looking from eyeView relative to the given head pose.
+    static osg::Matrix headViewOffset(const osg::Matrix& eyeView, const osg::Vec3& position, const osg::Quat& orientation);
+
+    // Predicts the head pose of each frame for the time it will be displayed, using the runtime's
+    // estimate of the time to photons plus offsetSeconds. Off by default, the poses returned by
+    // the compositor are used as they are. The error against the pose tracked at that time is
+    // reported as "OpenVR pose error" (mm) and "OpenVR pose error angle" (degrees).
+    void setPosePrediction(bool enabled, float offsetSeconds = 0.0f) { m_posePrediction = enabled; m_predictionOffset = offsetSeconds; }
+    bool posePrediction() const { return m_posePrediction; }
+    float predictionOffset() const { return m_predictionOffset; }
+
+    // Predicts the head pose once more right before each eye is drawn and sets the difference to
+    // the pose it was culled with as "osgvr_LateLatch", a mat4 in eye space applied after the
+    // model view matrix. Off by default. The single pass and shared cull stereo modes apply it
+    // themselves, with per eye cameras it is up to the scene's shaders.
+    void setLateLatch(bool enabled) { m_lateLatch = enabled; }
+    bool lateLatch() const { return m_lateLatch; }
+    // Correction for a camera looking from eyeView in the frame being drawn. Only for the draw thread.
+    osg::Matrix lateLatchCorrection(const osg::Matrix& eyeView) const;
+
+    // Starts a frame in the update traversal: takes the latest pose snapshot and applies a
+    // requested resolution scale, then queues the state for the draw of the frame.
+    void beginFrame(unsigned int frameNumber);
+    // State of the frame being updated and culled. Only for the update/cull thread.
+    const OpenVRFrameState& frameState() const { return m_frameState; }
+    // State of the frame being drawn, frames are drawn in the order they were begun. Only for the draw thread.
+    const OpenVRFrameState& drawFrameState() const;
+    // Called by the swap callback when the draw of a frame is complete.
+    void endDrawFrame();
+
+    // Must be selected before the render buffers are created at realize.
+    void setStereoMode(StereoMode mode) { m_stereoMode = mode; }
+    StereoMode stereoMode() const { return m_stereoMode; }
+
+    // Both eyes render into the left and right half of one buffer that is resolved once
+    // and submitted with per eye bounds. Always used by SINGLE_PASS. Set before realize.
+    void setEyeAtlas(bool atlas) { m_eyeAtlas = atlas; }
+    bool eyeAtlas() const { return m_eyeAtlas || m_stereoMode == SINGLE_PASS; }
 
     osg::Camera* createRTTCamera(OpenVRDevice::Eye eye, osg::Transform::ReferenceFrame referenceFrame, const osg::Vec4& clearColor, osg::GraphicsContext* gc = 0) const;
+    osg::Camera* createSinglePassStereoCamera(osg::Transform::ReferenceFrame referenceFrame, const osg::Vec4& clearColor, osg::GraphicsContext* gc = 0) const;
+    osg::Camera* createSharedCullCamera(osg::Transform::ReferenceFrame referenceFrame, const osg::Vec4& clearColor, osg::GraphicsContext* gc = 0) const;
+
+    OpenVRTextureBuffer* textureBuffer(OpenVRDevice::Eye eye) const { return m_textureBuffer[eye].get(); }
+
+    // Clears the eye's region of the bound texture buffer and masks its hidden area.
+    // The RTT cameras do not clear themselves, this is called at the start of each eye pass.
+    void beginEyePass(osg::RenderInfo& renderInfo, OpenVRDevice::Eye eye, const osg::Vec4& clearColor) const;
+
+    // Skip the pixels hidden by the lenses using the runtime's hidden area mesh, on by default.
+    void setHiddenAreaMaskEnabled(bool enabled) { m_hiddenAreaMaskEnabled = enabled; }
+    bool hiddenAreaMaskEnabled() const { return m_hiddenAreaMaskEnabled; }
+
+    // Number of resolve textures per eye buffer that are cycled through, 2 by default.
+    // Must be set before the render buffers are created at realize.
+    void setResolveBufferCount(int count) { m_resolveBufferCount = osg::maximum(count, 1); }
+    int resolveBufferCount() const { return m_resolveBufferCount; }
+
+    // Renders each eye into a part of its texture buffer, 1 is the recommended render target size.
+    // Can be called from any thread, the scale is applied when the next frame begins.
+    void setResolutionScale(float scale);
+    float resolutionScale() const { return m_frameState.resolutionScale; }
+
+    // Adjusts the resolution scale every frame from the measured GPU time, none by default.
+    void setResolutionGovernor(OpenVRResolutionGovernor* governor) { m_resolutionGovernor = governor; }
+    OpenVRResolutionGovernor* resolutionGovernor() const { return m_resolutionGovernor.get(); }
+    void updateResolutionScale();
+
+    // GPU time of drawing and resolving both eyes in a recent frame.
+    double gpuTimeMs() const;
+
+    // Region of the eye's texture buffer that holds the image of that eye. It is
+    // only changed by beginFrame() while no frame is being drawn.
+    const osg::Viewport* eyeViewport(OpenVRDevice::Eye eye) const { return m_eyeViewport[eye].get(); }
+    vr::VRTextureBounds_t textureBounds(OpenVRDevice::Eye eye) const;
+
+    // What the desktop window shows, MIRROR_BOTH by default.
+    void setMirrorMode(MirrorMode mode) { m_mirrorMode = mode; }
+    MirrorMode mirrorMode() const { return m_mirrorMode; }
+    // Updates the window only every n-th frame, 1 by default.
+    void setMirrorInterval(int frames) { m_mirrorInterval = osg::maximum(frames, 1); }
+    int mirrorInterval() const { return m_mirrorInterval; }
+
+    // Records the submitted eye images, none by default. Set before realize or from the draw thread.
+    void setFrameCapture(OpenVRFrameCapture* capture) { m_frameCapture = capture; }
+    OpenVRFrameCapture* frameCapture() const { return m_frameCapture.get(); }
+    void captureFrame(osg::GraphicsContext* gc);
 
     bool submitFrame();
-    void blitMirrorTexture(osg::GraphicsContext* gc);
+    // Returns false when the window was not drawn this frame and must not be swapped.
+    bool blitMirrorTexture(osg::GraphicsContext* gc);
 
-    osg::GraphicsContext::Traits* graphicsContextTraits() const;
+    // Traits of the mirror window, or of an offscreen pbuffer for runs without a display.
+    // Does not depend on the runtime, the window can be created while the device is initialized.
+    static osg::GraphicsContext::Traits* graphicsContextTraits(bool pbuffer = false);
 
-	uint32_t controllerEventResult = 0;  // ťĽ
-	osg::Vec2 m_touchpadTouchPosition;
-	osg::Vec2 m_touchpadPreTouchPosition;
 	osg::Vec3 m_leftControllerPosition;
-	osg::Vec3f averagePosition;
+
 	osg::Vec3 m_rightControllerPosition;
 	osg::Quat m_leftOrientation;
 	osg::Quat m_rightOrientation;
@@ -197,34 +450,85 @@ protected:
 
     void calculateEyeAdjustment();
     void calculateProjectionMatrices();
+    void calculateCombinedFrustum();
+    void applyResolutionScale(float scale);
+    // Head pose of m_frameState from its pose snapshot.
+    void updatePose();
+    // Adds the valid poses of m_frameState's snapshot to the device histories.
+    void recordPoseHistory();
+    void headPose(const vr::TrackedDevicePose_t& pose, osg::Vec3& position, osg::Quat& orientation) const;
+    // Replaces the head pose of m_frameState by the one predicted for its display.
+    void predictPose();
+    // Compares the predictions of frames that have been displayed by now with the tracked poses.
+    void recordPredictionError();
 
     void trySetProcessAsHighPriority() const;
 
-    vr::IVRSystem* m_vrSystem;
-    vr::IVRRenderModels* m_vrRenderModels;
+    osg::ref_ptr<OpenVRBackend> m_backend;
+    osg::observer_ptr<osg::Stats> m_stats;
     const float m_worldUnitsPerMetre;
 
     osg::ref_ptr<OpenVRTextureBuffer> m_textureBuffer[2];
+    osg::ref_ptr<osg::Viewport> m_eyeViewport[2];
+    osg::ref_ptr<osg::Viewport> m_stereoViewport; // both eyes of the single pass buffer
+    osg::ref_ptr<OpenVRResolutionGovernor> m_resolutionGovernor;
     osg::ref_ptr<OpenVRMirrorTexture> m_mirrorTexture;
+    osg::ref_ptr<OpenVRFrameCapture> m_frameCapture;
+    osg::ref_ptr<OpenVRPoseService> m_poseService;
+    osg::ref_ptr<OpenVRDeviceRegistry> m_deviceRegistry;
+    std::vector<OpenVRTrackedDevice> m_controllers; // copy of the registry's controllers for the update thread
+    osg::ref_ptr<OpenVRHiddenAreaMesh> m_hiddenAreaMesh[2];
+    osg::ref_ptr<osg::ColorMask> m_clearColorMask;
+    osg::ref_ptr<osg::Depth> m_clearDepth;
+    StereoMode m_stereoMode;
+    bool m_eyeAtlas;
+    bool m_hiddenAreaMaskEnabled;
+    float m_requestedResolutionScale;
+    uint32_t m_timedFrameIndex; // frame of the last compositor timing record seen by the governor
+    int m_resolveBufferCount;
+    MirrorMode m_mirrorMode;
+    int m_mirrorInterval;
+    unsigned int m_mirrorFrame;
+    unsigned int m_compositorMirrorRetryFrame; // m_mirrorFrame at which the compositor mirror is tried again after a failure
+    bool m_posePrediction;
+    float m_predictionOffset;
+    bool m_lateLatch;
+    unsigned int m_controllersRevision;
+    unsigned int m_poseWaitMs; // longest beginFrame() waits for the poses after a submit
 
     osg::Matrixf m_leftEyeProjectionMatrix;
     osg::Matrixf m_rightEyeProjectionMatrix;
     osg::Vec3f m_leftEyeAdjust;
     osg::Vec3f m_rightEyeAdjust;
-
-    osg::Vec3 m_position;
-    osg::Quat m_orientation;
+    osg::Matrixf m_combinedProjectionMatrix;
+    osg::Vec3f m_combinedApex;
+
+
+    OpenVRFrameState m_frameState;                        // frame being updated
+    OpenVRRigidPose m_rigidPoses[vr::k_unMaxTrackedDeviceCount]; // of m_frameState.poses, update thread only
+    OpenVRPoseHistory m_poseHistory[vr::k_unMaxTrackedDeviceCount];
+    OpenVRControllerEventQueue m_controllerEvents; // filled by HandleInput()
+    mutable OpenVRFrameState m_drawFrameState;            // frame being drawn
+    mutable bool m_drawFrameStarted;                      // m_drawFrameState taken from the queue
+    mutable std::deque<OpenVRFrameState> m_queuedFrames;  // begun, not yet drawn
+    mutable unsigned int m_framesInFlight;                // begun, draw not yet ended
+    mutable OpenThreads::Mutex m_frameStateMutex;         // guards the queue, the counter and the requested scale
+    OpenThreads::Condition m_frameDrawn;
+
+    // Device poses predicted by the update thread, in tracking space, until they are displayed
+    struct PosePrediction
+    {
+        osg::Timer_t photonTick;
+        osg::Vec3d position;
+        osg::Quat orientation;
+    };
+    std::deque<PosePrediction> m_predictions;
 
     float m_nearClip;
     float m_farClip;
     int m_samples;
 private:
-
-	uint32_t frameIndex = 0;
-	vr::VRControllerState_t state;
-	vr::VRControllerState_t prevState;
-	osg::ref_ptr<osg::Vec3Array> controller_poses = new osg::Vec3Array;
-    std::string GetDeviceProperty(vr::TrackedDeviceProperty prop);
+    void initialize();
     OpenVRDevice(const OpenVRDevice&); // Do not allow copy
     OpenVRDevice& operator=(const OpenVRDevice&); // Do not allow assignment operator.
 };
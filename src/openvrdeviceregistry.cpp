@@ -0,0 +1,148 @@
+/*
+ * openvrdeviceregistry.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrdeviceregistry.h"
+
+#include <osg/Notify>
+#include <OpenThreads/ScopedLock>
+
+OpenVRTrackedDevice::OpenVRTrackedDevice() :
+    index(vr::k_unTrackedDeviceIndexInvalid),
+    connected(false),
+    deviceClass(vr::TrackedDeviceClass_Invalid),
+    role(vr::TrackedControllerRole_Invalid)
+{
+}
+
+OpenVRDeviceRegistry::OpenVRDeviceRegistry(OpenVRBackend* backend) :
+    m_backend(backend),
+    m_revision(0)
+{
+    for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+    {
+        m_devices[i].index = i;
+    }
+}
+
+void OpenVRDeviceRegistry::scan()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+        {
+            query(i);
+        }
+        updateControllers();
+    }
+    m_revision.fetch_add(1, std::memory_order_release);
+}
+
+bool OpenVRDeviceRegistry::processEvent(const vr::VREvent_t& event)
+{
+    const vr::TrackedDeviceIndex_t index = event.trackedDeviceIndex;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        switch (event.eventType)
+        {
+            case vr::VREvent_TrackedDeviceActivated:
+            case vr::VREvent_TrackedDeviceUpdated:
+                if (index >= vr::k_unMaxTrackedDeviceCount)
+                {
+                    return false;
+                }
+                query(index);
+                if (event.eventType == vr::VREvent_TrackedDeviceActivated)
+                {
+                    osg::notify(osg::INFO) << "Tracked device " << index << " activated: " << m_devices[index].serialNumber
+                                           << " (" << m_devices[index].renderModelName << ")" << std::endl;
+                }
+                break;
+            case vr::VREvent_TrackedDeviceDeactivated:
+                if (index >= vr::k_unMaxTrackedDeviceCount)
+                {
+                    return false;
+                }
+                m_devices[index] = OpenVRTrackedDevice();
+                m_devices[index].index = index;
+                osg::notify(osg::INFO) << "Tracked device " << index << " deactivated" << std::endl;
+                break;
+            case vr::VREvent_TrackedDeviceRoleChanged:
+                // Roles may swap between controllers, the event does not always name the device.
+                for (vr::TrackedDeviceIndex_t controller : m_controllers)
+                {
+                    m_devices[controller].role = m_backend->controllerRole(controller);
+                }
+                break;
+            default:
+                return false;
+        }
+        updateControllers();
+    }
+    m_revision.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+OpenVRTrackedDevice OpenVRDeviceRegistry::device(vr::TrackedDeviceIndex_t index) const
+{
+    if (index >= vr::k_unMaxTrackedDeviceCount)
+    {
+        return OpenVRTrackedDevice();
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_devices[index];
+}
+
+vr::ETrackedControllerRole OpenVRDeviceRegistry::controllerRole(vr::TrackedDeviceIndex_t index) const
+{
+    if (index >= vr::k_unMaxTrackedDeviceCount)
+    {
+        return vr::TrackedControllerRole_Invalid;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_devices[index].role;
+}
+
+void OpenVRDeviceRegistry::controllers(std::vector<OpenVRTrackedDevice>& controllers) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    controllers.clear();
+    for (vr::TrackedDeviceIndex_t index : m_controllers)
+    {
+        controllers.push_back(m_devices[index]);
+    }
+}
+
+/* Protected functions */
+void OpenVRDeviceRegistry::query(vr::TrackedDeviceIndex_t index)
+{
+    OpenVRTrackedDevice& device = m_devices[index];
+    device.connected = m_backend->isTrackedDeviceConnected(index);
+    if (!device.connected)
+    {
+        device = OpenVRTrackedDevice();
+        device.index = index;
+        return;
+    }
+
+    device.deviceClass = m_backend->trackedDeviceClass(index);
+    device.role = (device.deviceClass == vr::TrackedDeviceClass_Controller) ? m_backend->controllerRole(index) : vr::TrackedControllerRole_Invalid;
+    device.serialNumber = m_backend->trackedDeviceProperty(index, vr::Prop_SerialNumber_String);
+    device.renderModelName = m_backend->trackedDeviceProperty(index, vr::Prop_RenderModelName_String);
+}
+
+void OpenVRDeviceRegistry::updateControllers()
+{
+    m_controllers.clear();
+    for (vr::TrackedDeviceIndex_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+    {
+        if (m_devices[i].connected && m_devices[i].deviceClass == vr::TrackedDeviceClass_Controller)
+        {
+            m_controllers.push_back(i);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * openvrdeviceregistry.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRDEVICEREGISTRY_H_
+#define _OSG_OPENVRDEVICEREGISTRY_H_
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <OpenThreads/Mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "openvrbackend.h"
+
+// What is known about a tracked device slot, queried once when the device appears.
+struct OpenVRTrackedDevice
+{
+    OpenVRTrackedDevice();
+
+    vr::TrackedDeviceIndex_t index;
+    bool connected;
+    vr::ETrackedDeviceClass deviceClass;
+    vr::ETrackedControllerRole role;
+    std::string serialNumber;
+    std::string renderModelName;
+};
+
+// Caches the class, role, serial number and render model of every tracked device, so the
+// frame loop does not ask the runtime for them every frame. The devices present at start
+// are scanned once, afterwards the registry only changes on activation, deactivation,
+// update and role change events. Events are handled on the thread polling them, readers
+// on other threads take a copy when revision() has changed.
+class OpenVRDeviceRegistry : public osg::Referenced
+{
+public:
+    explicit OpenVRDeviceRegistry(OpenVRBackend* backend);
+
+    // Queries all device slots, called once when the runtime has been initialized.
+    void scan();
+    // Returns true when the event changed the registry.
+    bool processEvent(const vr::VREvent_t& event);
+
+    // Incremented with every change.
+    unsigned int revision() const { return m_revision.load(std::memory_order_acquire); }
+
+    OpenVRTrackedDevice device(vr::TrackedDeviceIndex_t index) const;
+    vr::ETrackedControllerRole controllerRole(vr::TrackedDeviceIndex_t index) const;
+    // The connected controllers in index order.
+    void controllers(std::vector<OpenVRTrackedDevice>& controllers) const;
+
+protected:
+    ~OpenVRDeviceRegistry() {}
+
+    // Called with m_mutex held.
+    void query(vr::TrackedDeviceIndex_t index);
+    void updateControllers();
+
+    osg::ref_ptr<OpenVRBackend> m_backend;
+
+    mutable OpenThreads::Mutex m_mutex;
+    OpenVRTrackedDevice m_devices[vr::k_unMaxTrackedDeviceCount];
+    std::vector<vr::TrackedDeviceIndex_t> m_controllers; // connected controllers, compact
+    std::atomic<unsigned int> m_revision;
+};
+
+#endif /* _OSG_OPENVRDEVICEREGISTRY_H_ */
@@ -0,0 +1,310 @@
+/*
+ * openvrframecapture.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrframecapture.h"
+
+#include <osg/Version>
+#include <osg/BufferObject>
+#include <osg/FrameBufferObject>
+#include <osg/Math>
+#include <osg/Notify>
+#include <osgDB/FileUtils>
+#include <osgDB/WriteFile>
+#include <OpenThreads/ScopedLock>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <cstring>
+
+#if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
+    typedef osg::GLExtensions OSG_Buffer_Extensions;
+    typedef osg::GLExtensions OSG_FBO_Extensions;
+#else
+    typedef osg::GLBufferObject::Extensions OSG_Buffer_Extensions;
+    typedef osg::FBOExtensions OSG_FBO_Extensions;
+#endif
+
+static const OSG_Buffer_Extensions* getBufferExtensions(const osg::State& state)
+{
+#if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
+    return state.get<osg::GLExtensions>();
+#else
+    return osg::GLBufferObject::getExtensions(state.getContextID(), true);
+#endif
+}
+
+static const OSG_FBO_Extensions* getFBOExtensions(const osg::State& state)
+{
+#if(OSG_VERSION_GREATER_OR_EQUAL(3, 4, 0))
+    return state.get<osg::GLExtensions>();
+#else
+    return osg::FBOExtensions::instance(state.getContextID(), true);
+#endif
+}
+
+OpenVRFrameCapture::OpenVRFrameCapture(const std::string& directory, Format format, unsigned int pixelBuffers, unsigned int maxQueuedFrames) :
+    m_directory(directory),
+    m_format(format),
+    m_interval(1),
+    m_frames(0),
+    m_pixelBufferIndex(0),
+    m_capturedFrames(0),
+    m_rateFrames(0),
+    m_rateStartTick(osg::Timer::instance()->tick()),
+    m_captureRate(0.0),
+    m_maxQueuedFrames(maxQueuedFrames > 0 ? maxQueuedFrames : 1),
+    m_writtenFrames(0),
+    m_droppedFrames(0),
+    m_done(false),
+    m_writer(this)
+{
+    // Two buffers are the minimum, otherwise a buffer is mapped right after its copy was issued.
+    PixelBuffer empty = { 0, 0, 0, 0, 0, false };
+    m_pixelBuffers.resize(pixelBuffers > 2 ? pixelBuffers : 2, empty);
+
+    if (!osgDB::makeDirectory(m_directory))
+    {
+        osg::notify(osg::WARN) << "Warning: Could not create capture directory " << m_directory << std::endl;
+    }
+
+    m_writer.start();
+}
+
+OpenVRFrameCapture::~OpenVRFrameCapture()
+{
+    stopWriter();
+}
+
+void OpenVRFrameCapture::capture(osg::State& state, const Region* regions, unsigned int regionCount, unsigned int frameNumber)
+{
+    if ((m_frames++ % m_interval) != 0 || regionCount == 0)
+    {
+        return;
+    }
+
+    const OSG_Buffer_Extensions* buffer_ext = getBufferExtensions(state);
+    const OSG_FBO_Extensions* fbo_ext = getFBOExtensions(state);
+
+    PixelBuffer& pixelBuffer = m_pixelBuffers[m_pixelBufferIndex];
+    m_pixelBufferIndex = (m_pixelBufferIndex + 1) % m_pixelBuffers.size();
+
+    // The copy into this buffer was issued a full ring ago and has completed by now.
+    if (pixelBuffer.pending)
+    {
+        readPending(state, pixelBuffer);
+    }
+
+    GLint width = 0;
+    GLint height = 0;
+    for (unsigned int i = 0; i < regionCount; ++i)
+    {
+        width += regions[i].width;
+        height = osg::maximum(height, regions[i].height);
+    }
+    const GLsizeiptr size = static_cast<GLsizeiptr>(width) * height * 4;
+
+    if (pixelBuffer.buffer == 0)
+    {
+        buffer_ext->glGenBuffers(1, &pixelBuffer.buffer);
+    }
+    buffer_ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, pixelBuffer.buffer);
+    if (size > pixelBuffer.size)
+    {
+        buffer_ext->glBufferData(GL_PIXEL_PACK_BUFFER_ARB, size, nullptr, GL_STREAM_READ_ARB);
+        pixelBuffer.size = size;
+    }
+
+    // With a pack buffer bound glReadPixels only queues the copy, the offset is the region's column.
+    glPixelStorei(GL_PACK_ROW_LENGTH, width);
+    GLint column = 0;
+    for (unsigned int i = 0; i < regionCount; ++i)
+    {
+        const Region& region = regions[i];
+        fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, region.framebuffer);
+        glReadPixels(region.x, region.y, region.width, region.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                     reinterpret_cast<GLvoid*>(static_cast<size_t>(column) * 4));
+        column += region.width;
+    }
+    glPixelStorei(GL_PACK_ROW_LENGTH, 0);
+
+    buffer_ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+    fbo_ext->glBindFramebuffer(GL_READ_FRAMEBUFFER_EXT, 0);
+
+    pixelBuffer.width = width;
+    pixelBuffer.height = height;
+    pixelBuffer.frameNumber = frameNumber;
+    pixelBuffer.pending = true;
+    ++m_capturedFrames;
+
+    const osg::Timer_t now = osg::Timer::instance()->tick();
+    const double elapsed = osg::Timer::instance()->delta_s(m_rateStartTick, now);
+    if (elapsed >= 1.0)
+    {
+        m_captureRate = m_rateFrames / elapsed;
+        m_rateFrames = 0;
+        m_rateStartTick = now;
+    }
+}
+
+void OpenVRFrameCapture::destroy(osg::State& state)
+{
+    // Hand over the copies still in flight, oldest first.
+    for (size_t i = 0; i < m_pixelBuffers.size(); ++i)
+    {
+        PixelBuffer& pixelBuffer = m_pixelBuffers[(m_pixelBufferIndex + i) % m_pixelBuffers.size()];
+        if (pixelBuffer.pending)
+        {
+            readPending(state, pixelBuffer);
+        }
+    }
+
+    stopWriter();
+
+    const OSG_Buffer_Extensions* buffer_ext = getBufferExtensions(state);
+    for (PixelBuffer& pixelBuffer : m_pixelBuffers)
+    {
+        if (pixelBuffer.buffer != 0)
+        {
+            buffer_ext->glDeleteBuffers(1, &pixelBuffer.buffer);
+            pixelBuffer.buffer = 0;
+            pixelBuffer.size = 0;
+        }
+    }
+}
+
+unsigned int OpenVRFrameCapture::queueDepth() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return static_cast<unsigned int>(m_queue.size());
+}
+
+unsigned int OpenVRFrameCapture::writtenFrames() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_writtenFrames;
+}
+
+unsigned int OpenVRFrameCapture::droppedFrames() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_droppedFrames;
+}
+
+/* Protected functions */
+void OpenVRFrameCapture::readPending(osg::State& state, PixelBuffer& pixelBuffer)
+{
+    pixelBuffer.pending = false;
+
+    // Only this thread adds frames, so a queue with room now still has room after the copy.
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        if (m_queue.size() >= m_maxQueuedFrames)
+        {
+            ++m_droppedFrames;
+            return;
+        }
+    }
+
+    const OSG_Buffer_Extensions* buffer_ext = getBufferExtensions(state);
+    buffer_ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, pixelBuffer.buffer);
+    const void* data = buffer_ext->glMapBuffer(GL_PIXEL_PACK_BUFFER_ARB, GL_READ_ONLY_ARB);
+    if (data != nullptr)
+    {
+        Frame frame;
+        frame.frameNumber = pixelBuffer.frameNumber;
+        frame.image = new osg::Image;
+        frame.image->allocateImage(pixelBuffer.width, pixelBuffer.height, 1, GL_RGBA, GL_UNSIGNED_BYTE);
+        std::memcpy(frame.image->data(), data, frame.image->getTotalSizeInBytes());
+        buffer_ext->glUnmapBuffer(GL_PIXEL_PACK_BUFFER_ARB);
+
+        queueFrame(frame);
+        ++m_rateFrames;
+    }
+    buffer_ext->glBindBuffer(GL_PIXEL_PACK_BUFFER_ARB, 0);
+}
+
+bool OpenVRFrameCapture::queueFrame(const Frame& frame)
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        if (m_queue.size() >= m_maxQueuedFrames)
+        {
+            ++m_droppedFrames;
+            return false;
+        }
+        m_queue.push_back(frame);
+    }
+    m_condition.signal();
+    return true;
+}
+
+void OpenVRFrameCapture::writeFrames()
+{
+    while (true)
+    {
+        Frame frame;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+            while (m_queue.empty() && !m_done)
+            {
+                m_condition.wait(&m_mutex);
+            }
+            // Once stopped the remaining frames are still written.
+            if (m_queue.empty())
+            {
+                return;
+            }
+            frame = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        writeFrame(frame);
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        ++m_writtenFrames;
+    }
+}
+
+void OpenVRFrameCapture::writeFrame(const Frame& frame) const
+{
+    const osg::Image* image = frame.image.get();
+
+    std::ostringstream fileName;
+    fileName << m_directory << "/frame_" << std::setw(6) << std::setfill('0') << frame.frameNumber;
+
+    if (m_format == RAW)
+    {
+        fileName << "_" << image->s() << "x" << image->t() << ".rgba";
+        std::ofstream file(fileName.str().c_str(), std::ios::binary);
+        file.write(reinterpret_cast<const char*>(image->data()), image->getTotalSizeInBytes());
+        if (!file)
+        {
+            osg::notify(osg::WARN) << "Warning: Could not write capture " << fileName.str() << std::endl;
+        }
+    }
+    else
+    {
+        fileName << ".png";
+        if (!osgDB::writeImageFile(*image, fileName.str()))
+        {
+            osg::notify(osg::WARN) << "Warning: Could not write capture " << fileName.str() << std::endl;
+        }
+    }
+}
+
+void OpenVRFrameCapture::stopWriter()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_condition.broadcast();
+
+    if (m_writer.isRunning())
+    {
+        m_writer.join();
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * openvrframecapture.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRFRAMECAPTURE_H_
+#define _OSG_OPENVRFRAMECAPTURE_H_
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Image>
+#include <osg/State>
+#include <osg/Timer>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Records the eye images to disk without stalling the render thread. The resolved
+// eye buffers are read into a ring of pixel buffer objects, and each buffer is only
+// mapped when the ring comes around to it again, by then the copy has completed.
+// Mapped frames go to a writer thread through a bounded queue, a frame that finds
+// the queue full is dropped instead of waiting for the disk.
+class OpenVRFrameCapture : public osg::Referenced
+{
+public:
+    typedef enum Format_
+    {
+        RAW = 0, // RGBA8 rows bottom up, size in the file name
+        PNG = 1
+    } Format;
+
+    // Part of a framebuffer that is captured, the regions are stored side by side.
+    struct Region
+    {
+        GLuint framebuffer;
+        GLint x;
+        GLint y;
+        GLint width;
+        GLint height;
+    };
+
+    OpenVRFrameCapture(const std::string& directory, Format format = PNG, unsigned int pixelBuffers = 3, unsigned int maxQueuedFrames = 8);
+
+    // Captures only every n-th frame, 1 by default.
+    void setInterval(unsigned int frames) { m_interval = frames > 0 ? frames : 1; }
+    unsigned int interval() const { return m_interval; }
+
+    // Called on the graphics thread after the regions have been rendered.
+    void capture(osg::State& state, const Region* regions, unsigned int regionCount, unsigned int frameNumber);
+    // Writes the frames still queued, then releases the pixel buffers. Needs the graphics context current.
+    void destroy(osg::State& state);
+
+    double captureRate() const { return m_captureRate; } // frames handed to the writer per second
+    unsigned int queueDepth() const;
+    unsigned int capturedFrames() const { return m_capturedFrames; }
+    unsigned int writtenFrames() const;
+    unsigned int droppedFrames() const;
+
+protected:
+    ~OpenVRFrameCapture();
+
+    struct PixelBuffer
+    {
+        GLuint buffer;
+        GLsizeiptr size;
+        GLint width;
+        GLint height;
+        unsigned int frameNumber;
+        bool pending; // a copy has been issued that has not been mapped yet
+    };
+
+    struct Frame
+    {
+        osg::ref_ptr<osg::Image> image;
+        unsigned int frameNumber;
+    };
+
+    class WriterThread : public OpenThreads::Thread
+    {
+    public:
+        explicit WriterThread(OpenVRFrameCapture* capture) : m_capture(capture) {}
+        virtual void run() { m_capture->writeFrames(); }
+    protected:
+        OpenVRFrameCapture* m_capture;
+    };
+
+    void readPending(osg::State& state, PixelBuffer& pixelBuffer);
+    bool queueFrame(const Frame& frame);
+    void writeFrames();
+    void writeFrame(const Frame& frame) const;
+    void stopWriter();
+
+    std::string m_directory;
+    Format m_format;
+    unsigned int m_interval;
+    unsigned int m_frames;
+
+    std::vector<PixelBuffer> m_pixelBuffers;
+    unsigned int m_pixelBufferIndex;
+
+    unsigned int m_capturedFrames;
+    unsigned int m_rateFrames;
+    osg::Timer_t m_rateStartTick;
+    double m_captureRate;
+
+    // Shared with the writer thread
+    mutable OpenThreads::Mutex m_mutex;
+    OpenThreads::Condition m_condition;
+    std::deque<Frame> m_queue;
+    unsigned int m_maxQueuedFrames;
+    unsigned int m_writtenFrames;
+    unsigned int m_droppedFrames;
+    bool m_done;
+    WriterThread m_writer;
+};
+
+#endif /* _OSG_OPENVRFRAMECAPTURE_H_ */
@@ -0,0 +1,290 @@
+/*
+ * openvrhudtext.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrhudtext.h"
+
+#include <osg/Notify>
+#include <osgText/Glyph>
+#include <algorithm>
+#include <cstring>
+
+// Empty texels between glyphs, so linear filtering does not pick up the neighbours.
+static const unsigned int s_glyphPadding = 1;
+
+OpenVRHudText::OpenVRHudText(const std::string& fontFile, float characterSize, unsigned int glyphResolution, unsigned int atlasSize) :
+    osg::Geometry(),
+    m_font(osgText::readRefFontFile(fontFile)),
+    m_characterSize(characterSize),
+    m_glyphResolution(glyphResolution > 0 ? glyphResolution : osg::maximum(static_cast<unsigned int>(characterSize + 0.5f), 1u)),
+    m_shelfX(s_glyphPadding),
+    m_shelfY(s_glyphPadding),
+    m_shelfHeight(0),
+    m_atlasFull(false),
+    m_usedQuads(0)
+{
+    if (!m_font.valid())
+    {
+        osg::notify(osg::WARN) << "Warning: Could not read font " << fontFile << ", HUD text is not shown" << std::endl;
+    }
+
+    m_atlas = new osg::Image;
+    m_atlas->allocateImage(atlasSize, atlasSize, 1, GL_ALPHA, GL_UNSIGNED_BYTE);
+    std::memset(m_atlas->data(), 0, m_atlas->getTotalSizeInBytes());
+
+    m_atlasTexture = new osg::Texture2D(m_atlas.get());
+    m_atlasTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+    m_atlasTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+    m_atlasTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+    m_atlasTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+    m_atlasTexture->setResizeNonPowerOfTwoHint(false);
+
+    m_vertices = new osg::Vec3Array;
+    m_texCoords = new osg::Vec2Array;
+    m_colors = new osg::Vec4Array;
+    m_triangles = new osg::DrawElementsUInt(GL_TRIANGLES);
+
+    setDataVariance(osg::Object::DYNAMIC);
+    setUseDisplayList(false);
+    setUseVertexBufferObjects(true);
+    setVertexArray(m_vertices.get());
+    setTexCoordArray(0, m_texCoords.get(), osg::Array::BIND_PER_VERTEX);
+    setColorArray(m_colors.get(), osg::Array::BIND_PER_VERTEX);
+    addPrimitiveSet(m_triangles.get());
+
+    // The atlas image grows while labels are changed.
+    osg::StateSet* stateset = getOrCreateStateSet();
+    stateset->setDataVariance(osg::Object::DYNAMIC);
+    stateset->setTextureAttributeAndModes(0, m_atlasTexture.get(), osg::StateAttribute::ON);
+    stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+    stateset->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+}
+
+unsigned int OpenVRHudText::addLabel(const osg::Vec2& position, const std::string& text, const osg::Vec4& color)
+{
+    Label label;
+    label.position = position;
+    label.color = color;
+    label.firstQuad = static_cast<unsigned int>(m_vertices->size() / 4);
+    label.numQuads = 0;
+    m_labels.push_back(label);
+
+    setLabel(static_cast<unsigned int>(m_labels.size() - 1), text);
+    return static_cast<unsigned int>(m_labels.size() - 1);
+}
+
+bool OpenVRHudText::setLabel(unsigned int index, const std::string& text)
+{
+    Label& label = m_labels[index];
+    if (label.text == text && label.numQuads > 0)
+    {
+        return false;
+    }
+    label.text = text;
+
+    // Only glyphs get a quad, line breaks do not.
+    const osgText::String characters(text, osgText::String::ENCODING_UTF8);
+    unsigned int count = 0;
+    for (unsigned int charcode : characters)
+    {
+        if (charcode != '\n')
+        {
+            ++count;
+        }
+    }
+    if (count > label.numQuads || label.numQuads == 0)
+    {
+        // Room to grow, so a readout changing length every frame does not move every time.
+        reserveQuads(label, osg::maximum(osg::maximum(count, 2 * label.numQuads), 1u));
+    }
+
+    layoutLabel(m_labels[index]);
+    dirtyBuffers();
+    return true;
+}
+
+bool OpenVRHudText::setLabelColor(unsigned int index, const osg::Vec4& color)
+{
+    Label& label = m_labels[index];
+    if (label.color == color)
+    {
+        return false;
+    }
+    label.color = color;
+
+    std::fill(m_colors->begin() + label.firstQuad * 4, m_colors->begin() + (label.firstQuad + label.numQuads) * 4, color);
+    m_colors->dirty();
+    return true;
+}
+
+/* Protected functions */
+const OpenVRHudText::AtlasGlyph& OpenVRHudText::atlasGlyph(unsigned int charcode)
+{
+    std::map<unsigned int, AtlasGlyph>::iterator itr = m_atlasGlyphs.find(charcode);
+    if (itr != m_atlasGlyphs.end())
+    {
+        return itr->second;
+    }
+
+    AtlasGlyph& atlasGlyph = m_atlasGlyphs[charcode];
+    atlasGlyph.advance = 0.0f;
+    atlasGlyph.visible = false;
+    if (!m_font.valid())
+    {
+        return atlasGlyph;
+    }
+
+    osgText::Glyph* glyph = m_font->getGlyph(osgText::FontResolution(m_glyphResolution, m_glyphResolution), charcode);
+    if (glyph == nullptr)
+    {
+        return atlasGlyph;
+    }
+    // Glyph metrics are relative to the character height.
+    atlasGlyph.advance = glyph->getHorizontalAdvance() * m_characterSize;
+
+    const unsigned int width = glyph->s();
+    const unsigned int height = glyph->t();
+    if (width == 0 || height == 0 || glyph->getPixelSizeInBits() != 8)
+    {
+        return atlasGlyph;
+    }
+
+    // Next shelf when the row is full, nothing more once the atlas is.
+    if (m_shelfX + width + s_glyphPadding > static_cast<unsigned int>(m_atlas->s()))
+    {
+        m_shelfX = s_glyphPadding;
+        m_shelfY += m_shelfHeight + s_glyphPadding;
+        m_shelfHeight = 0;
+    }
+    if (m_shelfY + height + s_glyphPadding > static_cast<unsigned int>(m_atlas->t()))
+    {
+        if (!m_atlasFull)
+        {
+            osg::notify(osg::WARN) << "Warning: HUD text glyph atlas is full, " << m_atlasGlyphs.size() << " glyphs" << std::endl;
+            m_atlasFull = true;
+        }
+        return atlasGlyph;
+    }
+
+    for (unsigned int row = 0; row < height; ++row)
+    {
+        std::memcpy(m_atlas->data(m_shelfX, m_shelfY + row), glyph->data(0, row), width);
+    }
+    m_atlas->dirty();
+
+    const float atlasWidth = static_cast<float>(m_atlas->s());
+    const float atlasHeight = static_cast<float>(m_atlas->t());
+    atlasGlyph.texMin.set(m_shelfX / atlasWidth, m_shelfY / atlasHeight);
+    atlasGlyph.texMax.set((m_shelfX + width) / atlasWidth, (m_shelfY + height) / atlasHeight);
+    atlasGlyph.offset = glyph->getHorizontalBearing() * m_characterSize;
+    atlasGlyph.size.set(glyph->getWidth() * m_characterSize, glyph->getHeight() * m_characterSize);
+    atlasGlyph.visible = true;
+
+    m_shelfX += width + s_glyphPadding;
+    m_shelfHeight = osg::maximum(m_shelfHeight, height);
+    return atlasGlyph;
+}
+
+void OpenVRHudText::reserveQuads(Label& label, unsigned int count)
+{
+    // The old span is collapsed and abandoned, the label moves to the end of the buffer.
+    std::fill(m_vertices->begin() + label.firstQuad * 4, m_vertices->begin() + (label.firstQuad + label.numQuads) * 4,
+              osg::Vec3(label.position, 0.0f));
+    m_usedQuads = m_usedQuads - label.numQuads + count;
+
+    const unsigned int totalQuads = static_cast<unsigned int>(m_vertices->size() / 4);
+    label.firstQuad = totalQuads;
+    label.numQuads = count;
+    if (totalQuads + count > 2 * m_usedQuads)
+    {
+        compact();
+        return;
+    }
+
+    m_vertices->resize((totalQuads + count) * 4);
+    m_texCoords->resize((totalQuads + count) * 4);
+    m_colors->resize((totalQuads + count) * 4);
+    for (unsigned int quad = totalQuads; quad < totalQuads + count; ++quad)
+    {
+        const GLuint first = quad * 4;
+        const GLuint indices[] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+        m_triangles->insert(m_triangles->end(), indices, indices + 6);
+    }
+    m_triangles->dirty();
+}
+
+void OpenVRHudText::layoutLabel(const Label& label)
+{
+    const osgText::String characters(label.text, osgText::String::ENCODING_UTF8);
+    osg::Vec2 pen = label.position;
+    unsigned int quad = label.firstQuad;
+    const unsigned int endQuad = label.firstQuad + label.numQuads;
+
+    for (unsigned int charcode : characters)
+    {
+        if (charcode == '\n')
+        {
+            pen.set(label.position.x(), pen.y() - m_characterSize);
+            continue;
+        }
+
+        const AtlasGlyph& glyph = atlasGlyph(charcode);
+        if (glyph.visible && quad < endQuad)
+        {
+            const osg::Vec2 min = pen + glyph.offset;
+            const osg::Vec2 max = min + glyph.size;
+            const unsigned int first = quad * 4;
+            (*m_vertices)[first].set(min.x(), min.y(), 0.0f);
+            (*m_vertices)[first + 1].set(max.x(), min.y(), 0.0f);
+            (*m_vertices)[first + 2].set(max.x(), max.y(), 0.0f);
+            (*m_vertices)[first + 3].set(min.x(), max.y(), 0.0f);
+            (*m_texCoords)[first].set(glyph.texMin.x(), glyph.texMin.y());
+            (*m_texCoords)[first + 1].set(glyph.texMax.x(), glyph.texMin.y());
+            (*m_texCoords)[first + 2].set(glyph.texMax.x(), glyph.texMax.y());
+            (*m_texCoords)[first + 3].set(glyph.texMin.x(), glyph.texMax.y());
+            ++quad;
+        }
+        pen.x() += glyph.advance;
+    }
+
+    // Unused quads have no area, they are placed on the label so the bound stays tight.
+    std::fill(m_vertices->begin() + quad * 4, m_vertices->begin() + endQuad * 4, osg::Vec3(label.position, 0.0f));
+    std::fill(m_colors->begin() + label.firstQuad * 4, m_colors->begin() + endQuad * 4, label.color);
+}
+
+void OpenVRHudText::compact()
+{
+    // Packs the labels again and drops the abandoned spans.
+    unsigned int totalQuads = 0;
+    for (Label& label : m_labels)
+    {
+        label.firstQuad = totalQuads;
+        totalQuads += label.numQuads;
+    }
+
+    m_vertices->resize(totalQuads * 4);
+    m_texCoords->resize(totalQuads * 4);
+    m_colors->resize(totalQuads * 4);
+    m_triangles->clear();
+    for (GLuint first = 0; first < totalQuads * 4; first += 4)
+    {
+        const GLuint indices[] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+        m_triangles->insert(m_triangles->end(), indices, indices + 6);
+    }
+    m_triangles->dirty();
+
+    for (const Label& label : m_labels)
+    {
+        layoutLabel(label);
+    }
+}
+
+void OpenVRHudText::dirtyBuffers()
+{
+    m_vertices->dirty();
+    m_texCoords->dirty();
+    m_colors->dirty();
+    dirtyBound();
+}
@@ -0,0 +1,92 @@
+/*
+ * openvrhudtext.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRHUDTEXT_H_
+#define _OSG_OPENVRHUDTEXT_H_
+
+#include <osg/Geometry>
+#include <osg/Image>
+#include <osg/Texture2D>
+#include <osgText/Font>
+#include <osgText/String>
+#include <map>
+#include <string>
+#include <vector>
+
+// Draws any number of text labels with one draw call. The glyphs of all labels are copied
+// into one alpha atlas texture when they are first used, and every label owns a span of
+// quads in one shared vertex buffer. Changing a label only lays out that span again, the
+// buffer is uploaded once in the next draw. Positions and the character size are in the
+// units of the parent, e.g. pixels of an OSGHudVR layer. Labels are changed from the
+// update traversal, the drawable is DYNAMIC.
+class OpenVRHudText : public osg::Geometry
+{
+public:
+    // A glyph resolution of 0 rasterizes the glyphs at the character size, for text in pixels.
+    OpenVRHudText(const std::string& fontFile, float characterSize, unsigned int glyphResolution = 0, unsigned int atlasSize = 1024);
+
+    // Returns the index of the new label. Text is UTF-8, '\n' starts a new line below.
+    unsigned int addLabel(const osg::Vec2& position, const std::string& text, const osg::Vec4& color = osg::Vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    // Returns false when the text or color was already the same and nothing changed.
+    bool setLabel(unsigned int label, const std::string& text);
+    bool setLabelColor(unsigned int label, const osg::Vec4& color);
+    unsigned int numLabels() const { return static_cast<unsigned int>(m_labels.size()); }
+
+    float characterSize() const { return m_characterSize; }
+    unsigned int numGlyphs() const { return static_cast<unsigned int>(m_atlasGlyphs.size()); }
+
+protected:
+    ~OpenVRHudText() {}
+
+    struct Label
+    {
+        osg::Vec2 position;
+        std::string text;
+        osg::Vec4 color;
+        unsigned int firstQuad;
+        unsigned int numQuads; // quads reserved for the label, unused ones are collapsed
+    };
+
+    // Where a glyph is in the atlas and how it is placed relative to the pen position.
+    struct AtlasGlyph
+    {
+        osg::Vec2 texMin;
+        osg::Vec2 texMax;
+        osg::Vec2 offset;  // bottom left corner
+        osg::Vec2 size;
+        float advance;
+        bool visible;      // false for spaces and glyphs that did not fit
+    };
+
+    const AtlasGlyph& atlasGlyph(unsigned int charcode);
+    void reserveQuads(Label& label, unsigned int count);
+    void layoutLabel(const Label& label);
+    void compact();
+    void dirtyBuffers();
+
+    osg::ref_ptr<osgText::Font> m_font;
+    float m_characterSize;
+    unsigned int m_glyphResolution;
+
+    osg::ref_ptr<osg::Image> m_atlas;
+    osg::ref_ptr<osg::Texture2D> m_atlasTexture;
+    std::map<unsigned int, AtlasGlyph> m_atlasGlyphs;
+    // Shelf packing of the atlas.
+    unsigned int m_shelfX;
+    unsigned int m_shelfY;
+    unsigned int m_shelfHeight;
+    bool m_atlasFull;
+
+    std::vector<Label> m_labels;
+    unsigned int m_usedQuads;  // quads reserved by labels, the rest of the buffer is abandoned spans
+
+    osg::ref_ptr<osg::Vec3Array> m_vertices;
+    osg::ref_ptr<osg::Vec2Array> m_texCoords;
+    osg::ref_ptr<osg::Vec4Array> m_colors;
+    osg::ref_ptr<osg::DrawElementsUInt> m_triangles;
+};
+
+#endif /* _OSG_OPENVRHUDTEXT_H_ */
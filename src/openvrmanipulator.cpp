@@ -0,0 +1,159 @@
+/*
+ * openvrmanipulator.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrmanipulator.h"
+#include "openvrdevice.h"
+
+#include <cmath>
+
+// Touchpad positions closer to the center than this are ignored.
+static const float touchpadDeadZone = 0.15f;
+
+static float applyDeadZone(float value)
+{
+    if (std::fabs(value) < touchpadDeadZone)
+    {
+        return 0.0f;
+    }
+    return (value - std::copysign(touchpadDeadZone, value)) / (1.0f - touchpadDeadZone);
+}
+
+OpenVRManipulator::OpenVRManipulator(OpenVRDevice* device) :
+    m_device(device),
+    m_mode(ROTATE),
+    m_rotationSpeed(osg::PI_2),
+    m_zoomSpeed(1.0),
+    m_flySpeed(0.0),
+    m_controller(vr::k_unTrackedDeviceIndexInvalid),
+    m_touchpadPressed(false),
+    m_triggerPressed(false),
+    m_lastFrameTime(-1.0)
+{
+}
+
+/* Protected functions */
+bool OpenVRManipulator::handleFrame(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& us)
+{
+    const bool handled = osgGA::OrbitManipulator::handleFrame(ea, us);
+
+    osg::ref_ptr<OpenVRDevice> device;
+    if (!m_device.lock(device))
+    {
+        return handled;
+    }
+
+    handleControllerEvents();
+
+    const double frameTime = ea.getTime();
+    const double dt = (m_lastFrameTime < 0.0) ? 0.0 : frameTime - m_lastFrameTime;
+    m_lastFrameTime = frameTime;
+
+    if ((!m_touchpadPressed && !m_triggerPressed) || dt <= 0.0)
+    {
+        return handled;
+    }
+
+    // The touchpad position is only sent with the press, it is read again every frame.
+    vr::VRControllerState_t state;
+    if (!device->backend()->controllerState(m_controller, state))
+    {
+        return handled;
+    }
+
+    const double flySpeed = (m_flySpeed > 0.0) ? m_flySpeed : _distance;
+    if (m_touchpadPressed)
+    {
+        const osg::Vec2f touchpad(applyDeadZone(state.rAxis[0].x), applyDeadZone(state.rAxis[0].y));
+        switch (m_mode)
+        {
+            case ROTATE:
+                rotateYawPitch(_rotation, -touchpad.x() * m_rotationSpeed * dt, touchpad.y() * m_rotationSpeed * dt,
+                               getUpVector(getCoordinateFrame(_center)));
+                break;
+            case ZOOM:
+                zoomModel(static_cast<float>(-touchpad.y() * m_zoomSpeed * dt), true);
+                break;
+            case FLY:
+            {
+                const osg::Vec3d forward = controllerDirection();
+                osg::Vec3d side = forward ^ getUpVector(getCoordinateFrame(_center));
+                side.normalize();
+                _center += (forward * touchpad.y() + side * touchpad.x()) * (flySpeed * dt);
+                break;
+            }
+        }
+    }
+    if (m_triggerPressed)
+    {
+        _center += controllerDirection() * (state.rAxis[1].x * flySpeed * dt);
+    }
+
+    us.requestRedraw();
+    return handled;
+}
+
+void OpenVRManipulator::handleControllerEvents()
+{
+    OpenVRControllerEvent event;
+    while (m_device->nextControllerEvent(event))
+    {
+        const bool pressed = (event.type == OpenVRControllerEvent::BUTTON_PRESS);
+        if (!pressed && event.type != OpenVRControllerEvent::BUTTON_UNPRESS)
+        {
+            continue;
+        }
+
+        switch (event.button)
+        {
+            case vr::k_EButton_SteamVR_Touchpad:
+            case vr::k_EButton_SteamVR_Trigger:
+                break;
+            case vr::k_EButton_ApplicationMenu:
+                if (pressed)
+                {
+                    m_mode = static_cast<Mode>((m_mode + 1) % (FLY + 1));
+                }
+                continue;
+            default:
+                continue;
+        }
+
+        // One controller moves the view at a time, the others are ignored until it lets go of
+        // both buttons. Their presses are not remembered, they have to be pressed again.
+        if ((m_touchpadPressed || m_triggerPressed) && event.device != m_controller)
+        {
+            continue;
+        }
+        m_controller = event.device;
+        if (event.button == vr::k_EButton_SteamVR_Touchpad)
+        {
+            m_touchpadPressed = pressed;
+        }
+        else
+        {
+            m_triggerPressed = pressed;
+        }
+    }
+}
+
+osg::Vec3d OpenVRManipulator::controllerDirection() const
+{
+    // Controllers point along their -z axis. Tracking space is the eye space of the
+    // manipulator's camera, before the head pose is applied.
+    osg::Vec3d direction(0.0, 0.0, -1.0);
+    if (m_controller < vr::k_unMaxTrackedDeviceCount)
+    {
+        const OpenVRPoseHistory& history = m_device->poseHistory(m_controller);
+        if (!history.empty())
+        {
+            direction = history.latest().orientation * direction;
+        }
+    }
+
+    direction = osg::Matrixd::transform3x3(direction, getMatrix());
+    direction.normalize();
+    return direction;
+}
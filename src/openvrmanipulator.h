@@ -0,0 +1,69 @@
+/*
+ * openvrmanipulator.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRMANIPULATOR_H_
+#define _OSG_OPENVRMANIPULATOR_H_
+
+#include <osgGA/OrbitManipulator>
+#include <osg/observer_ptr>
+
+// Forward declaration
+class OpenVRDevice;
+
+// Orbit manipulator driven by the controllers. Every frame event it takes the controller
+// events queued by the device and, while the touchpad is pressed, the touchpad position,
+// and moves the view before the update traversal sets the camera of the same frame.
+// Touchpad: rotate around the center, zoom towards it, or fly where the controller points.
+// Trigger: flies where the controller points in every mode, faster the harder it is pulled.
+// Application menu button: switches to the next mode.
+// One controller moves the view at a time, the first to press the touchpad or trigger.
+// Mouse and keyboard still work as with the OrbitManipulator.
+class OpenVRManipulator : public osgGA::OrbitManipulator
+{
+public:
+    enum Mode
+    {
+        ROTATE,
+        ZOOM,
+        FLY
+    };
+
+    explicit OpenVRManipulator(OpenVRDevice* device);
+
+    virtual const char* className() const { return "OpenVRManipulator"; }
+
+    void setMode(Mode mode) { m_mode = mode; }
+    Mode mode() const { return m_mode; }
+
+    // Radians per second with the thumb at the edge of the touchpad.
+    void setRotationSpeed(double radiansPerSecond) { m_rotationSpeed = radiansPerSecond; }
+    // Relative change of the distance to the center per second.
+    void setZoomSpeed(double scalePerSecond) { m_zoomSpeed = scalePerSecond; }
+    // World units per second, 0 (the default) flies at the distance to the center per second.
+    void setFlySpeed(double unitsPerSecond) { m_flySpeed = unitsPerSecond; }
+
+protected:
+    virtual ~OpenVRManipulator() {}
+
+    virtual bool handleFrame(const osgGA::GUIEventAdapter& ea, osgGA::GUIActionAdapter& us);
+
+    void handleControllerEvents();
+    // Direction the active controller points to in world coordinates.
+    osg::Vec3d controllerDirection() const;
+
+    osg::observer_ptr<OpenVRDevice> m_device;
+    Mode m_mode;
+    double m_rotationSpeed;
+    double m_zoomSpeed;
+    double m_flySpeed;
+
+    unsigned int m_controller;  // tracked device index of the controller moving the view, or the last one that did
+    bool m_touchpadPressed;
+    bool m_triggerPressed;
+    double m_lastFrameTime;     // negative before the first frame
+};
+
+#endif /* _OSG_OPENVRMANIPULATOR_H_ */
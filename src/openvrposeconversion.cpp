@@ -0,0 +1,251 @@
+/*
+ * openvrposeconversion.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrposeconversion.h"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#define OPENVR_POSE_AVX
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define OPENVR_POSE_SSE
+#include <xmmintrin.h>
+#endif
+
+// Quaternion of a rotation matrix with Shepperd's method: the largest of 4w^2, 4x^2, 4y^2
+// and 4z^2 is taken from the diagonal, the other components from the off diagonal sums and
+// differences divided by it. The divisor is at least 1, so the result is accurate for all
+// rotations, including half turns where w is 0. The same choice and formulas are used by the
+// scalar and the vectorized paths so they give the same results.
+static void convertPose(const vr::TrackedDevicePose_t& pose, OpenVRRigidPose& result)
+{
+    const float (*m)[4] = pose.mDeviceToAbsoluteTracking.m;
+    const float tx = m[0][3], ty = m[1][3], tz = m[2][3];
+
+    // Each candidate is 4 times the squared component, in the order w, x, y, z, and the
+    // quaternion scaled by 4 times that component.
+    float t = (1.0f + m[0][0]) + (m[1][1] + m[2][2]);
+    float q[4] = { m[2][1] - m[1][2], m[0][2] - m[2][0], m[1][0] - m[0][1], t };
+    const float tX = (1.0f + m[0][0]) - (m[1][1] + m[2][2]);
+    if (tX > t)
+    {
+        t = tX;
+        q[0] = tX; q[1] = m[1][0] + m[0][1]; q[2] = m[0][2] + m[2][0]; q[3] = m[2][1] - m[1][2];
+    }
+    const float tY = (1.0f + m[1][1]) - (m[0][0] + m[2][2]);
+    if (tY > t)
+    {
+        t = tY;
+        q[0] = m[1][0] + m[0][1]; q[1] = tY; q[2] = m[2][1] + m[1][2]; q[3] = m[0][2] - m[2][0];
+    }
+    const float tZ = (1.0f + m[2][2]) - (m[0][0] + m[1][1]);
+    if (tZ > t)
+    {
+        t = tZ;
+        q[0] = m[0][2] + m[2][0]; q[1] = m[2][1] + m[1][2]; q[2] = tZ; q[3] = m[1][0] - m[0][1];
+    }
+    const float scale = 0.5f / std::sqrt(t);
+    const float x = q[0] * scale, y = q[1] * scale, z = q[2] * scale, w = q[3] * scale;
+
+    result.position.set(tx, ty, tz);
+    result.orientation.set(x, y, z, w);
+    result.inversePosition.set(-(m[0][0] * tx + m[1][0] * ty + m[2][0] * tz),
+                               -(m[0][1] * tx + m[1][1] * ty + m[2][1] * tz),
+                               -(m[0][2] * tx + m[1][2] * ty + m[2][2] * tz));
+    result.inverseOrientation.set(-x, -y, -z, w);
+    result.valid = pose.bPoseIsValid;
+}
+
+#if defined(OPENVR_POSE_SSE) || defined(OPENVR_POSE_AVX)
+
+// Outputs per lane: position, orientation and inverse position.
+enum { TX, TY, TZ, QX, QY, QZ, QW, IX, IY, IZ, OUTPUTS };
+
+#if defined(OPENVR_POSE_AVX)
+struct PoseOps
+{
+    typedef __m256 V;
+    static const unsigned int WIDTH = 8;
+
+    static V add(V a, V b) { return _mm256_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm256_div_ps(a, b); }
+    static V sqrt(V a) { return _mm256_sqrt_ps(a); }
+    static V neg(V a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.0f)); }
+    static V splat(float f) { return _mm256_set1_ps(f); }
+    static V greater(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static V select(V mask, V a, V b) { return _mm256_blendv_ps(b, a, mask); } // a where mask is set
+    static void store(float* out, V a) { _mm256_storeu_ps(out, a); }
+
+    // Rows of poses i..i+3 in the low lane and i+4..i+7 in the high lane, then a 4x4 transpose per lane.
+    static void load(const vr::TrackedDevicePose_t* poses, V m[3][4])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            V r[4];
+            for (int j = 0; j < 4; ++j)
+            {
+                r[j] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(poses[j].mDeviceToAbsoluteTracking.m[row])),
+                                            _mm_loadu_ps(poses[j + 4].mDeviceToAbsoluteTracking.m[row]), 1);
+            }
+            const V t0 = _mm256_unpacklo_ps(r[0], r[1]);
+            const V t1 = _mm256_unpacklo_ps(r[2], r[3]);
+            const V t2 = _mm256_unpackhi_ps(r[0], r[1]);
+            const V t3 = _mm256_unpackhi_ps(r[2], r[3]);
+            m[row][0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+            m[row][1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+            m[row][2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            m[row][3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        }
+    }
+};
+#else
+struct PoseOps
+{
+    typedef __m128 V;
+    static const unsigned int WIDTH = 4;
+
+    static V add(V a, V b) { return _mm_add_ps(a, b); }
+    static V sub(V a, V b) { return _mm_sub_ps(a, b); }
+    static V mul(V a, V b) { return _mm_mul_ps(a, b); }
+    static V div(V a, V b) { return _mm_div_ps(a, b); }
+    static V sqrt(V a) { return _mm_sqrt_ps(a); }
+    static V neg(V a) { return _mm_xor_ps(a, _mm_set1_ps(-0.0f)); }
+    static V splat(float f) { return _mm_set1_ps(f); }
+    static V greater(V a, V b) { return _mm_cmpgt_ps(a, b); }
+    static V select(V mask, V a, V b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); } // a where mask is set
+    static void store(float* out, V a) { _mm_storeu_ps(out, a); }
+
+    // One matrix row per pose, transposed so each register holds one element of all four.
+    static void load(const vr::TrackedDevicePose_t* poses, V m[3][4])
+    {
+        for (int row = 0; row < 3; ++row)
+        {
+            m[row][0] = _mm_loadu_ps(poses[0].mDeviceToAbsoluteTracking.m[row]);
+            m[row][1] = _mm_loadu_ps(poses[1].mDeviceToAbsoluteTracking.m[row]);
+            m[row][2] = _mm_loadu_ps(poses[2].mDeviceToAbsoluteTracking.m[row]);
+            m[row][3] = _mm_loadu_ps(poses[3].mDeviceToAbsoluteTracking.m[row]);
+            _MM_TRANSPOSE4_PS(m[row][0], m[row][1], m[row][2], m[row][3]);
+        }
+    }
+};
+#endif
+
+// Same formulas as convertPose(), for PoseOps::WIDTH poses at once. The branches
+// of Shepperd's method are all computed and selected per lane.
+static unsigned int convertBlocks(const vr::TrackedDevicePose_t* poses, unsigned int count, OpenVRRigidPose* result)
+{
+    typedef PoseOps::V V;
+    const unsigned int width = PoseOps::WIDTH;
+    const V half = PoseOps::splat(0.5f);
+    const V one = PoseOps::splat(1.0f);
+
+    unsigned int i = 0;
+    for (; i + width <= count; i += width)
+    {
+        V m[3][4];
+        PoseOps::load(poses + i, m);
+
+        const V& tx = m[0][3];
+        const V& ty = m[1][3];
+        const V& tz = m[2][3];
+
+        float out[OUTPUTS][width];
+        PoseOps::store(out[TX], tx);
+        PoseOps::store(out[TY], ty);
+        PoseOps::store(out[TZ], tz);
+
+        const V d00 = m[0][0], d11 = m[1][1], d22 = m[2][2];
+        const V diffX = PoseOps::sub(m[2][1], m[1][2]);
+        const V diffY = PoseOps::sub(m[0][2], m[2][0]);
+        const V diffZ = PoseOps::sub(m[1][0], m[0][1]);
+        const V sumXY = PoseOps::add(m[1][0], m[0][1]);
+        const V sumXZ = PoseOps::add(m[0][2], m[2][0]);
+        const V sumYZ = PoseOps::add(m[2][1], m[1][2]);
+
+        V t = PoseOps::add(PoseOps::add(one, d00), PoseOps::add(d11, d22));
+        V x = diffX, y = diffY, z = diffZ, w = t;
+
+        const V tX = PoseOps::sub(PoseOps::add(one, d00), PoseOps::add(d11, d22));
+        V mask = PoseOps::greater(tX, t);
+        t = PoseOps::select(mask, tX, t);
+        x = PoseOps::select(mask, tX, x);
+        y = PoseOps::select(mask, sumXY, y);
+        z = PoseOps::select(mask, sumXZ, z);
+        w = PoseOps::select(mask, diffX, w);
+
+        const V tY = PoseOps::sub(PoseOps::add(one, d11), PoseOps::add(d00, d22));
+        mask = PoseOps::greater(tY, t);
+        t = PoseOps::select(mask, tY, t);
+        x = PoseOps::select(mask, sumXY, x);
+        y = PoseOps::select(mask, tY, y);
+        z = PoseOps::select(mask, sumYZ, z);
+        w = PoseOps::select(mask, diffY, w);
+
+        const V tZ = PoseOps::sub(PoseOps::add(one, d22), PoseOps::add(d00, d11));
+        mask = PoseOps::greater(tZ, t);
+        t = PoseOps::select(mask, tZ, t);
+        x = PoseOps::select(mask, sumXZ, x);
+        y = PoseOps::select(mask, sumYZ, y);
+        z = PoseOps::select(mask, tZ, z);
+        w = PoseOps::select(mask, diffZ, w);
+
+        const V scale = PoseOps::div(half, PoseOps::sqrt(t));
+        PoseOps::store(out[QX], PoseOps::mul(x, scale));
+        PoseOps::store(out[QY], PoseOps::mul(y, scale));
+        PoseOps::store(out[QZ], PoseOps::mul(z, scale));
+        PoseOps::store(out[QW], PoseOps::mul(w, scale));
+
+        for (int column = 0; column < 3; ++column)
+        {
+            const V dot = PoseOps::add(PoseOps::add(PoseOps::mul(m[0][column], tx), PoseOps::mul(m[1][column], ty)), PoseOps::mul(m[2][column], tz));
+            PoseOps::store(out[IX + column], PoseOps::neg(dot));
+        }
+
+        for (unsigned int lane = 0; lane < width; ++lane)
+        {
+            OpenVRRigidPose& pose = result[i + lane];
+            pose.position.set(out[TX][lane], out[TY][lane], out[TZ][lane]);
+            pose.orientation.set(out[QX][lane], out[QY][lane], out[QZ][lane], out[QW][lane]);
+            pose.inversePosition.set(out[IX][lane], out[IY][lane], out[IZ][lane]);
+            pose.inverseOrientation.set(-out[QX][lane], -out[QY][lane], -out[QZ][lane], out[QW][lane]);
+            pose.valid = poses[i + lane].bPoseIsValid;
+        }
+    }
+    return i;
+}
+#endif
+
+/* Public functions */
+void OpenVRPoseConversion::convert(const vr::TrackedDevicePose_t* poses, unsigned int count, OpenVRRigidPose* result)
+{
+    unsigned int converted = 0;
+#if defined(OPENVR_POSE_SSE) || defined(OPENVR_POSE_AVX)
+    converted = convertBlocks(poses, count, result);
+#endif
+    convertScalar(poses + converted, count - converted, result + converted);
+}
+
+void OpenVRPoseConversion::convertScalar(const vr::TrackedDevicePose_t* poses, unsigned int count, OpenVRRigidPose* result)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        convertPose(poses[i], result[i]);
+    }
+}
+
+const char* OpenVRPoseConversion::instructionSet()
+{
+#if defined(OPENVR_POSE_AVX)
+    return "AVX";
+#elif defined(OPENVR_POSE_SSE)
+    return "SSE";
+#else
+    return "scalar";
+#endif
+}
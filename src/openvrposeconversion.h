@@ -0,0 +1,40 @@
+/*
+ * openvrposeconversion.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRPOSECONVERSION_H_
+#define _OSG_OPENVRPOSECONVERSION_H_
+
+#include <osg/Vec3f>
+#include <osg/Quat>
+
+#include "openvrbackend.h"
+
+// Device pose in tracking space and its inverse, which is the view of the device.
+struct OpenVRRigidPose
+{
+    osg::Vec3f position;
+    osg::Quat orientation;
+    osg::Vec3f inversePosition;
+    osg::Quat inverseOrientation;
+    bool valid;
+};
+
+// Converts OpenVR poses into positions and quaternions. Tracked device poses are rigid,
+// so the inverse is the transposed rotation applied to the negated translation and no
+// general matrix inverse or decomposition is needed. Poses are converted in blocks of
+// 4 with SSE, or 8 when the library is built with AVX, the rest one at a time.
+class OpenVRPoseConversion
+{
+public:
+    static void convert(const vr::TrackedDevicePose_t* poses, unsigned int count, OpenVRRigidPose* result);
+    // Always one pose at a time, for comparison with the vectorized path.
+    static void convertScalar(const vr::TrackedDevicePose_t* poses, unsigned int count, OpenVRRigidPose* result);
+
+    // "AVX", "SSE" or "scalar", the instructions convert() was compiled for.
+    static const char* instructionSet();
+};
+
+#endif /* _OSG_OPENVRPOSECONVERSION_H_ */
@@ -0,0 +1,125 @@
+/*
+ * openvrposehistory.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrposehistory.h"
+
+#include <algorithm>
+
+OpenVRPoseSample::OpenVRPoseSample() :
+    tick(0)
+{
+}
+
+OpenVRPoseHistory::OpenVRPoseHistory(unsigned int capacity) :
+    m_samples(std::max(capacity, 1u)),
+    m_next(0),
+    m_size(0)
+{
+}
+
+void OpenVRPoseHistory::add(const OpenVRPoseSample& sample)
+{
+    const osg::Vec3d position(sample.position);
+    const osg::Vec3d previousMean = m_mean;
+
+    if (m_size < capacity())
+    {
+        ++m_size;
+        m_mean += (position - previousMean) / m_size;
+        m_squaredDeviations += osg::componentMultiply(position - previousMean, position - m_mean);
+    }
+    else
+    {
+        // The newest sample takes the place of the oldest one, the count stays the same.
+        const osg::Vec3d replaced(m_samples[m_next].position);
+        m_mean += (position - replaced) / m_size;
+        m_squaredDeviations += osg::componentMultiply(position - replaced, position - m_mean + replaced - previousMean);
+    }
+
+    m_samples[m_next] = sample;
+    m_next = (m_next + 1) % capacity();
+}
+
+void OpenVRPoseHistory::clear()
+{
+    m_next = 0;
+    m_size = 0;
+    m_mean.set(0.0, 0.0, 0.0);
+    m_squaredDeviations.set(0.0, 0.0, 0.0);
+}
+
+const OpenVRPoseSample& OpenVRPoseHistory::sample(unsigned int age) const
+{
+    const unsigned int count = capacity();
+    return m_samples[(m_next + count - 1 - (age % count)) % count];
+}
+
+osg::Vec3d OpenVRPoseHistory::positionVariance() const
+{
+    if (m_size == 0)
+    {
+        return osg::Vec3d();
+    }
+
+    // Rounding may leave tiny negative values once samples have been replaced many times.
+    return osg::Vec3d(std::max(0.0, m_squaredDeviations.x()),
+                      std::max(0.0, m_squaredDeviations.y()),
+                      std::max(0.0, m_squaredDeviations.z())) / m_size;
+}
+
+bool OpenVRPoseHistory::velocity(double seconds, osg::Vec3d& velocity) const
+{
+    const unsigned int count = samplesWithin(seconds);
+    if (count < 2)
+    {
+        return false;
+    }
+
+    const OpenVRPoseSample& newest = sample(0);
+    const OpenVRPoseSample& oldest = sample(count - 1);
+    const double elapsed = osg::Timer::instance()->delta_s(oldest.tick, newest.tick);
+    if (elapsed <= 0.0)
+    {
+        return false;
+    }
+
+    velocity = osg::Vec3d(newest.position - oldest.position) / elapsed;
+    return true;
+}
+
+bool OpenVRPoseHistory::reportedVelocity(double seconds, osg::Vec3d& velocity) const
+{
+    const unsigned int count = samplesWithin(seconds);
+    if (count < 2)
+    {
+        return false;
+    }
+
+    osg::Vec3d sum;
+    for (unsigned int age = 0; age < count; ++age)
+    {
+        sum += osg::Vec3d(sample(age).velocity);
+    }
+    velocity = sum / count;
+    return true;
+}
+
+/* Protected functions */
+unsigned int OpenVRPoseHistory::samplesWithin(double seconds) const
+{
+    if (m_size == 0)
+    {
+        return 0;
+    }
+
+    const osg::Timer_t newest = sample(0).tick;
+    unsigned int count = 1;
+    while (count < m_size && osg::Timer::instance()->delta_s(sample(count).tick, newest) <= seconds)
+    {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,70 @@
+/*
+ * openvrposehistory.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRPOSEHISTORY_H_
+#define _OSG_OPENVRPOSEHISTORY_H_
+
+#include <osg/Vec3f>
+#include <osg/Vec3d>
+#include <osg/Quat>
+#include <osg/Timer>
+#include <vector>
+
+// One tracked pose of a device, in tracking space and metres.
+struct OpenVRPoseSample
+{
+    OpenVRPoseSample();
+
+    osg::Timer_t tick;        // when the pose was received
+    osg::Vec3f position;
+    osg::Quat orientation;
+    osg::Vec3f velocity;        // metres per second, as reported by the runtime
+    osg::Vec3f angularVelocity; // radians per second
+};
+
+// The last capacity() poses of a device in a ring buffer allocated once, so adding
+// a sample never allocates. Mean and variance of the positions in the buffer are
+// updated in constant time as samples are added and the oldest ones replaced.
+class OpenVRPoseHistory
+{
+public:
+    explicit OpenVRPoseHistory(unsigned int capacity = 128);
+
+    void add(const OpenVRPoseSample& sample);
+    void clear();
+
+    unsigned int capacity() const { return static_cast<unsigned int>(m_samples.size()); }
+    unsigned int size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    // 0 is the newest sample, size() - 1 the oldest.
+    const OpenVRPoseSample& sample(unsigned int age) const;
+    const OpenVRPoseSample& latest() const { return sample(0); }
+
+    // Of the positions of all samples in the buffer, zero when empty.
+    const osg::Vec3d& meanPosition() const { return m_mean; }
+    osg::Vec3d positionVariance() const;
+
+    // Average velocity over the samples received in the last seconds before the newest one,
+    // from the distance travelled. Returns false when the period holds fewer than two samples.
+    bool velocity(double seconds, osg::Vec3d& velocity) const;
+    // Mean of the velocities reported by the runtime over the same period.
+    bool reportedVelocity(double seconds, osg::Vec3d& velocity) const;
+
+protected:
+    // Number of samples, newest first, that were received within seconds of the newest one.
+    unsigned int samplesWithin(double seconds) const;
+
+    std::vector<OpenVRPoseSample> m_samples;
+    unsigned int m_next; // slot the next sample is written to
+    unsigned int m_size;
+
+    // Rolling statistics of the positions (Welford's method with replacement)
+    osg::Vec3d m_mean;
+    osg::Vec3d m_squaredDeviations;
+};
+
+#endif /* _OSG_OPENVRPOSEHISTORY_H_ */
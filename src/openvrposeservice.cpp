@@ -0,0 +1,151 @@
+/*
+ * openvrposeservice.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrposeservice.h"
+
+#include <OpenThreads/ScopedLock>
+
+OpenVRPoseSnapshot::OpenVRPoseSnapshot() :
+    frameIndex(0),
+    waitTick(0),
+    posesTick(0)
+{
+    for (unsigned int i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+    {
+        poses[i].bPoseIsValid = false;
+        poses[i].bDeviceIsConnected = false;
+    }
+}
+
+OpenVRPoseService::OpenVRPoseService(OpenVRBackend* backend) :
+    m_backend(backend),
+    m_back(0),
+    m_middle(1),
+    m_front(2),
+    m_submittedFrames(0),
+    m_publishedFrames(0),
+    m_done(false),
+    m_thread(this)
+{
+}
+
+OpenVRPoseService::~OpenVRPoseService()
+{
+    stop();
+}
+
+void OpenVRPoseService::start()
+{
+    if (m_thread.isRunning())
+    {
+        return;
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_done = false;
+    }
+    m_thread.start();
+}
+
+void OpenVRPoseService::stop()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_condition.broadcast();
+
+    if (m_thread.isRunning())
+    {
+        m_thread.join();
+    }
+}
+
+void OpenVRPoseService::frameSubmitted()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        ++m_submittedFrames;
+    }
+    m_condition.broadcast();
+}
+
+bool OpenVRPoseService::waitForLatestPoses(unsigned int timeoutMs)
+{
+    const osg::Timer* timer = osg::Timer::instance();
+    const osg::Timer_t startTick = timer->tick();
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    while (m_publishedFrames <= m_submittedFrames && !m_done)
+    {
+        const double elapsedMs = timer->delta_m(startTick, timer->tick());
+        if (elapsedMs >= timeoutMs)
+        {
+            return false;
+        }
+        m_condition.wait(&m_mutex, static_cast<unsigned long>(timeoutMs - elapsedMs) + 1);
+    }
+    return m_publishedFrames > m_submittedFrames;
+}
+
+const OpenVRPoseSnapshot& OpenVRPoseService::latest()
+{
+    // Swapping the front slot for the middle one hands the old front back to the pose thread.
+    if (m_middle.load(std::memory_order_relaxed) & NEW_SNAPSHOT)
+    {
+        m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & SLOT_MASK;
+    }
+    return m_slots[m_front];
+}
+
+/* Protected functions */
+void OpenVRPoseService::waitForPoses()
+{
+    m_backend->setTrackingSpace(vr::TrackingUniverseSeated);
+
+    const osg::Timer* timer = osg::Timer::instance();
+    for (unsigned int frameIndex = 1; ; ++frameIndex)
+    {
+        // The compositor hands out the poses for the next frame only after the previous one was submitted.
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+            while (m_submittedFrames + 1 < frameIndex && !m_done)
+            {
+                m_condition.wait(&m_mutex);
+            }
+            if (m_done)
+            {
+                return;
+            }
+        }
+
+        OpenVRPoseSnapshot& snapshot = m_slots[m_back];
+        for (unsigned int i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+        {
+            snapshot.poses[i].bPoseIsValid = false;
+        }
+        snapshot.waitTick = timer->tick();
+        m_backend->waitGetPoses(snapshot.poses, vr::k_unMaxTrackedDeviceCount);
+        snapshot.posesTick = timer->tick();
+        snapshot.frameIndex = frameIndex;
+
+        publish();
+
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+            m_publishedFrames = frameIndex;
+        }
+        m_condition.broadcast();
+    }
+}
+
+void OpenVRPoseService::publish()
+{
+    // The previous middle slot becomes the next one to write, unless the reader took it
+    // in the meantime, then it is the reader's old slot. Either way nobody reads it.
+    m_back = m_middle.exchange(m_back | NEW_SNAPSHOT, std::memory_order_acq_rel) & SLOT_MASK;
+}
@@ -0,0 +1,93 @@
+/*
+ * openvrposeservice.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRPOSESERVICE_H_
+#define _OSG_OPENVRPOSESERVICE_H_
+
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <osg/Timer>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <atomic>
+
+#include "openvrbackend.h"
+
+// Poses of all tracked devices as returned by one waitGetPoses() call. Never
+// changed once published, a reader sees either all of it or none of it.
+struct OpenVRPoseSnapshot
+{
+    OpenVRPoseSnapshot();
+
+    unsigned int frameIndex;  // 1 for the first poses, 0 before any have been received
+    osg::Timer_t waitTick;    // when waitGetPoses() was called
+    osg::Timer_t posesTick;   // when it returned
+    vr::TrackedDevicePose_t poses[vr::k_unMaxTrackedDeviceCount];
+};
+
+// Runs the blocking waitGetPoses() of the compositor on its own thread, so neither
+// the draw nor the update thread sleeps until vsync. The poses after a submitted
+// frame are requested as soon as the submit has happened and published through a
+// triple buffer: the pose thread always has a slot to write and the reader always
+// keeps the slot it is reading, so publishing and taking a snapshot never lock.
+// Only the pacing between submit and wait goes through a mutex and condition.
+class OpenVRPoseService : public osg::Referenced
+{
+public:
+    explicit OpenVRPoseService(OpenVRBackend* backend);
+
+    void start();
+    // Returns once the pose thread has left waitGetPoses(), call before the backend is shut down.
+    void stop();
+
+    // Called after both eyes of a frame have been submitted, lets the pose thread wait for the next poses.
+    void frameSubmitted();
+
+    // Waits until the poses following the last submitted frame have been published, at most timeoutMs.
+    // Returns false on timeout, the previous snapshot is then still the latest.
+    bool waitForLatestPoses(unsigned int timeoutMs);
+
+    // Newest published snapshot. Lock free, but there must be only a single reading thread:
+    // the snapshot stays valid and unchanged until that thread calls latest() again.
+    const OpenVRPoseSnapshot& latest();
+
+protected:
+    ~OpenVRPoseService();
+
+    class PoseThread : public OpenThreads::Thread
+    {
+    public:
+        explicit PoseThread(OpenVRPoseService* service) : m_service(service) {}
+        virtual void run() { m_service->waitForPoses(); }
+    protected:
+        OpenVRPoseService* m_service;
+    };
+
+    void waitForPoses();
+    void publish();
+
+    // Slot index in the low bits, NEW_SNAPSHOT set while the middle slot has not been taken yet.
+    static const unsigned int SLOT_MASK = 0x3;
+    static const unsigned int NEW_SNAPSHOT = 0x4;
+
+    osg::ref_ptr<OpenVRBackend> m_backend;
+
+    OpenVRPoseSnapshot m_slots[3];
+    unsigned int m_back;                 // written by the pose thread
+    std::atomic<unsigned int> m_middle;  // last published, exchanged by both threads
+    unsigned int m_front;                // read by the reading thread
+
+    // Pacing, shared with the pose thread
+    OpenThreads::Mutex m_mutex;
+    OpenThreads::Condition m_condition;
+    unsigned int m_submittedFrames;
+    unsigned int m_publishedFrames;
+    bool m_done;
+    PoseThread m_thread;
+};
+
+#endif /* _OSG_OPENVRPOSESERVICE_H_ */
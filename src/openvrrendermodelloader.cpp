@@ -0,0 +1,249 @@
+/*
+ * openvrrendermodelloader.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrrendermodelloader.h"
+#include "openvrcachefile.h"
+
+#include <osg/Geode>
+#include <osg/Geometry>
+#include <osg/Image>
+#include <osg/Notify>
+#include <osg/Texture2D>
+#include <osg/Version>
+#include <osgDB/FileUtils>
+#include <osgDB/ReadFile>
+#include <OpenThreads/ScopedLock>
+#include <cstring>
+
+// How long the loader thread sleeps between polls of the runtime's asynchronous load.
+static const unsigned int s_pollIntervalUs = 5000;
+
+OpenVRRenderModelLoader::OpenVRRenderModelLoader(OpenVRBackend* backend, const std::string& cacheDirectory) :
+    m_backend(backend),
+    m_cacheDirectory(cacheDirectory),
+    m_thread(this),
+    m_done(false)
+{
+    if (!m_cacheDirectory.empty() && !osgDB::makeDirectory(m_cacheDirectory))
+    {
+        osg::notify(osg::WARN) << "Warning: Could not create render model cache directory " << m_cacheDirectory << std::endl;
+        m_cacheDirectory.clear();
+    }
+
+    m_thread.start();
+}
+
+OpenVRRenderModelLoader::~OpenVRRenderModelLoader()
+{
+    stop();
+}
+
+void OpenVRRenderModelLoader::request(const std::string& name)
+{
+    if (name.empty())
+    {
+        return;
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        if (m_done || m_models.find(name) != m_models.end())
+        {
+            return;
+        }
+        m_models[name] = nullptr;
+        m_queue.push_back(name);
+    }
+    m_requested.signal();
+}
+
+osg::ref_ptr<osg::Node> OpenVRRenderModelLoader::model(const std::string& name) const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    std::map<std::string, osg::ref_ptr<osg::Node> >::const_iterator itr = m_models.find(name);
+    return (itr != m_models.end()) ? itr->second : nullptr;
+}
+
+void OpenVRRenderModelLoader::stop()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_done = true;
+    }
+    m_requested.broadcast();
+
+    if (m_thread.isRunning())
+    {
+        m_thread.join();
+    }
+}
+
+/* Protected functions */
+bool OpenVRRenderModelLoader::done() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_done;
+}
+
+void OpenVRRenderModelLoader::loadRequests()
+{
+    while (true)
+    {
+        std::string name;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+            while (m_queue.empty() && !m_done)
+            {
+                m_requested.wait(&m_mutex);
+            }
+            if (m_done)
+            {
+                return;
+            }
+            name = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        osg::ref_ptr<osg::Node> model = load(name);
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_models[name] = model;
+    }
+}
+
+osg::ref_ptr<osg::Node> OpenVRRenderModelLoader::load(const std::string& name)
+{
+    const std::string fileName = cacheFileName(name);
+    if (!fileName.empty() && osgDB::fileExists(fileName))
+    {
+        osg::ref_ptr<osg::Node> cached = osgDB::readRefNodeFile(fileName);
+        if (cached.valid())
+        {
+            osg::notify(osg::INFO) << "Render model " << name << " read from " << fileName << std::endl;
+            return cached;
+        }
+        osg::notify(osg::WARN) << "Warning: Could not read cached render model " << fileName << ", loading it again" << std::endl;
+    }
+
+    osg::ref_ptr<osg::Node> model = loadFromRuntime(name);
+    if (model.valid() && !fileName.empty())
+    {
+        OpenVRCacheFile::writeNode(*model, fileName);
+    }
+    return model;
+}
+
+osg::ref_ptr<osg::Node> OpenVRRenderModelLoader::loadFromRuntime(const std::string& name)
+{
+    vr::RenderModel_t* renderModel = nullptr;
+    vr::EVRRenderModelError error;
+    while ((error = m_backend->loadRenderModel(name, &renderModel)) == vr::VRRenderModelError_Loading)
+    {
+        if (done())
+        {
+            return nullptr;
+        }
+        OpenThreads::Thread::microSleep(s_pollIntervalUs);
+    }
+    if (error != vr::VRRenderModelError_None)
+    {
+        osg::notify(osg::WARN) << "Warning: Could not load render model " << name << " (error " << error << ")" << std::endl;
+        return nullptr;
+    }
+
+    vr::RenderModel_TextureMap_t* textureMap = nullptr;
+    while ((error = m_backend->loadRenderModelTexture(renderModel->diffuseTextureId, &textureMap)) == vr::VRRenderModelError_Loading)
+    {
+        if (done())
+        {
+            m_backend->freeRenderModel(renderModel);
+            return nullptr;
+        }
+        OpenThreads::Thread::microSleep(s_pollIntervalUs);
+    }
+    if (error != vr::VRRenderModelError_None)
+    {
+        osg::notify(osg::WARN) << "Warning: Could not load the texture of render model " << name << " (error " << error << ")" << std::endl;
+        textureMap = nullptr;
+    }
+
+    // Render models are in metres in the device's coordinate system, like the tracked poses.
+    osg::ref_ptr<osg::Vec3Array> vertices = new osg::Vec3Array(renderModel->unVertexCount);
+    osg::ref_ptr<osg::Vec3Array> normals = new osg::Vec3Array(renderModel->unVertexCount);
+    osg::ref_ptr<osg::Vec2Array> texCoords = new osg::Vec2Array(renderModel->unVertexCount);
+    for (uint32_t i = 0; i < renderModel->unVertexCount; ++i)
+    {
+        const vr::RenderModel_Vertex_t& vertex = renderModel->rVertexData[i];
+        (*vertices)[i].set(vertex.vPosition.v[0], vertex.vPosition.v[1], vertex.vPosition.v[2]);
+        (*normals)[i].set(vertex.vNormal.v[0], vertex.vNormal.v[1], vertex.vNormal.v[2]);
+        // Texture rows are uploaded in the runtime's order, so the coordinates stay as they are.
+        (*texCoords)[i].set(vertex.rfTextureCoord[0], vertex.rfTextureCoord[1]);
+    }
+
+    osg::ref_ptr<osg::DrawElementsUShort> triangles = new osg::DrawElementsUShort(GL_TRIANGLES,
+        renderModel->rIndexData, renderModel->rIndexData + renderModel->unTriangleCount * 3);
+
+    osg::ref_ptr<osg::Geometry> geometry = new osg::Geometry;
+    geometry->setUseDisplayList(false);
+    geometry->setUseVertexBufferObjects(true);
+    geometry->setVertexArray(vertices.get());
+    geometry->setNormalArray(normals.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->setTexCoordArray(0, texCoords.get(), osg::Array::BIND_PER_VERTEX);
+    geometry->addPrimitiveSet(triangles.get());
+
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    geode->setName(name);
+    geode->addDrawable(geometry.get());
+
+    if (textureMap != nullptr)
+    {
+        osg::ref_ptr<osg::Image> image = new osg::Image;
+        const unsigned int size = textureMap->unWidth * textureMap->unHeight * 4;
+        unsigned char* pixels = new unsigned char[size];
+        std::memcpy(pixels, textureMap->rubTextureMapData, size);
+        image->setImage(textureMap->unWidth, textureMap->unHeight, 1, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE, pixels, osg::Image::USE_NEW_DELETE);
+
+        osg::ref_ptr<osg::Texture2D> texture = new osg::Texture2D(image.get());
+        texture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR_MIPMAP_LINEAR);
+        texture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+        texture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+        texture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+        geode->getOrCreateStateSet()->setTextureAttributeAndModes(0, texture.get(), osg::StateAttribute::ON);
+
+        m_backend->freeRenderModelTexture(textureMap);
+    }
+    m_backend->freeRenderModel(renderModel);
+
+    return geode;
+}
+
+std::string OpenVRRenderModelLoader::cacheFileName(const std::string& name) const
+{
+    if (m_cacheDirectory.empty())
+    {
+        return "";
+    }
+
+    // Without a version an outdated file could not be told apart, such models are not cached.
+    const std::string version = m_backend->renderModelVersion(name);
+    if (version.empty())
+    {
+        return "";
+    }
+
+    // Model names may contain path separators, e.g. those of third party devices.
+    std::string fileName = name;
+    for (char& c : fileName)
+    {
+        if (c == '/' || c == '\\' || c == ':')
+        {
+            c = '_';
+        }
+    }
+    // Also changes with the OSG version, whose .osgb files may not be readable by others.
+    const uint64_t hash = OpenVRCacheFile::hashString(osgGetVersion(), OpenVRCacheFile::hashString(version));
+    return m_cacheDirectory + "/" + fileName + "." + OpenVRCacheFile::hexString(hash) + ".osgb";
+}
@@ -0,0 +1,73 @@
+/*
+ * openvrrendermodelloader.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRRENDERMODELLOADER_H_
+#define _OSG_OPENVRRENDERMODELLOADER_H_
+
+#include <osg/Node>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <OpenThreads/Condition>
+#include <deque>
+#include <map>
+#include <string>
+
+#include "openvrbackend.h"
+
+// Loads the render models of tracked devices on a background thread. The runtime's
+// asynchronous load is polled there, the mesh and texture are converted into one
+// osg::Geode per model name that every device with that model shares. Converted
+// models are written to a cache directory as .osgb files and read from there on
+// later launches, which skips both the runtime load and the conversion. The cache
+// file names include the backend's version of the model, so an updated model is
+// converted again.
+class OpenVRRenderModelLoader : public osg::Referenced
+{
+public:
+    // An empty cache directory disables the disk cache.
+    OpenVRRenderModelLoader(OpenVRBackend* backend, const std::string& cacheDirectory);
+
+    // Queues the model for loading unless it has been requested before. Does not block.
+    void request(const std::string& name);
+    // The loaded model, null while it is still loading or when loading failed.
+    osg::ref_ptr<osg::Node> model(const std::string& name) const;
+
+    // Returns once the loader thread has finished, call before the backend is shut down.
+    void stop();
+
+protected:
+    ~OpenVRRenderModelLoader();
+
+    class LoaderThread : public OpenThreads::Thread
+    {
+    public:
+        explicit LoaderThread(OpenVRRenderModelLoader* loader) : m_loader(loader) {}
+        virtual void run() { m_loader->loadRequests(); }
+    protected:
+        OpenVRRenderModelLoader* m_loader;
+    };
+
+    // Runs on the loader thread until stop() is called.
+    void loadRequests();
+    bool done() const;
+    osg::ref_ptr<osg::Node> load(const std::string& name);
+    osg::ref_ptr<osg::Node> loadFromRuntime(const std::string& name);
+    std::string cacheFileName(const std::string& name) const;
+
+    osg::ref_ptr<OpenVRBackend> m_backend;
+    std::string m_cacheDirectory;
+    LoaderThread m_thread;
+
+    mutable OpenThreads::Mutex m_mutex;   // guards everything below
+    OpenThreads::Condition m_requested;
+    std::deque<std::string> m_queue;
+    std::map<std::string, osg::ref_ptr<osg::Node> > m_models; // null until loaded
+    bool m_done;
+};
+
+#endif /* _OSG_OPENVRRENDERMODELLOADER_H_ */
@@ -0,0 +1,109 @@
+/*
+ * openvrresolutiongovernor.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrresolutiongovernor.h"
+
+#include <osg/Math>
+#include <cmath>
+
+// Scale step when raising the resolution, and frames until GPU timings of a new resolution arrive.
+static const float s_increaseStep = 0.05f;
+static const unsigned int s_settleFrames = 4;
+
+/* Public functions */
+OpenVRResolutionGovernor::OpenVRResolutionGovernor(float minScale, float maxScale) :
+    m_minScale(minScale),
+    m_maxScale(maxScale),
+    m_scale(maxScale),
+    m_lowWatermark(0.7f),
+    m_highWatermark(0.9f),
+    m_increaseDelay(30),
+    m_framesBelow(0),
+    m_settleFrames(0),
+    m_smoothedGpuTimeMs(0.0)
+{
+    setScaleRange(minScale, maxScale);
+}
+
+void OpenVRResolutionGovernor::setScaleRange(float minScale, float maxScale)
+{
+    m_maxScale = osg::clampBetween(maxScale, 0.1f, 1.0f);
+    m_minScale = osg::clampBetween(minScale, 0.1f, m_maxScale);
+    m_scale = osg::clampBetween(m_scale, m_minScale, m_maxScale);
+}
+
+void OpenVRResolutionGovernor::setWatermarks(float low, float high)
+{
+    m_highWatermark = high;
+    m_lowWatermark = osg::minimum(low, high);
+}
+
+float OpenVRResolutionGovernor::update(double gpuTimeMs, double frameBudgetMs, bool droppedFrame)
+{
+    if (m_settleFrames > 0)
+    {
+        --m_settleFrames;
+        return m_scale;
+    }
+
+    if (gpuTimeMs <= 0.0 || frameBudgetMs <= 0.0)
+    {
+        if (droppedFrame)
+        {
+            changeScale(m_scale - s_increaseStep);
+        }
+        return m_scale;
+    }
+
+    // Follow increases at once, decreases smoothed so a single short frame does not raise the scale.
+    if (gpuTimeMs > m_smoothedGpuTimeMs)
+    {
+        m_smoothedGpuTimeMs = gpuTimeMs;
+    }
+    else
+    {
+        m_smoothedGpuTimeMs += 0.1 * (gpuTimeMs - m_smoothedGpuTimeMs);
+    }
+
+    const double load = m_smoothedGpuTimeMs / frameBudgetMs;
+    if (load > m_highWatermark || droppedFrame)
+    {
+        // GPU time is roughly proportional to the pixel count, i.e. to the square of the scale.
+        // Aim for the middle between the watermarks, but always go down at least one step.
+        const double target = 0.5 * (m_lowWatermark + m_highWatermark);
+        const float scale = static_cast<float>(m_scale * sqrt(target / osg::maximum(load, target)));
+        changeScale(osg::minimum(scale, m_scale - s_increaseStep));
+    }
+    else if (load < m_lowWatermark && m_scale < m_maxScale)
+    {
+        if (++m_framesBelow >= m_increaseDelay)
+        {
+            changeScale(m_scale + s_increaseStep);
+        }
+    }
+    else
+    {
+        m_framesBelow = 0;
+    }
+
+    return m_scale;
+}
+
+/* Protected functions */
+void OpenVRResolutionGovernor::changeScale(float scale)
+{
+    scale = osg::clampBetween(scale, m_minScale, m_maxScale);
+    if (scale == m_scale)
+    {
+        return;
+    }
+
+    // Expected GPU time at the new resolution until it has been measured.
+    m_smoothedGpuTimeMs *= (scale * scale) / (m_scale * m_scale);
+    m_scale = scale;
+    m_framesBelow = 0;
+    m_settleFrames = s_settleFrames;
+}
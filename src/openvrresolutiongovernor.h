@@ -0,0 +1,50 @@
+/*
+ * openvrresolutiongovernor.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRRESOLUTIONGOVERNOR_H_
+#define _OSG_OPENVRRESOLUTIONGOVERNOR_H_
+
+#include <osg/Referenced>
+
+// Chooses the per eye resolution scale from the GPU time of the last frames.
+// A frame over the high watermark of the frame budget (or a dropped frame) lowers
+// the scale at once, it is raised again in small steps only after the GPU time
+// stayed below the low watermark for a number of frames. After every change the
+// governor waits for the measurements of the new resolution before deciding again.
+class OpenVRResolutionGovernor : public osg::Referenced
+{
+public:
+    OpenVRResolutionGovernor(float minScale = 0.6f, float maxScale = 1.0f);
+
+    void setScaleRange(float minScale, float maxScale);
+    float minScale() const { return m_minScale; }
+    float maxScale() const { return m_maxScale; }
+
+    // Fractions of the frame budget, e.g. 0.7 and 0.9.
+    void setWatermarks(float low, float high);
+    void setIncreaseDelay(unsigned int frames) { m_increaseDelay = frames; }
+
+    // Returns the scale for the next frame. gpuTimeMs <= 0 means no measurement this frame.
+    float update(double gpuTimeMs, double frameBudgetMs, bool droppedFrame);
+    float scale() const { return m_scale; }
+
+protected:
+    ~OpenVRResolutionGovernor() {}
+
+    void changeScale(float scale);
+
+    float m_minScale;
+    float m_maxScale;
+    float m_scale;
+    float m_lowWatermark;
+    float m_highWatermark;
+    unsigned int m_increaseDelay;
+    unsigned int m_framesBelow;
+    unsigned int m_settleFrames;
+    double m_smoothedGpuTimeMs;
+};
+
+#endif /* _OSG_OPENVRRESOLUTIONGOVERNOR_H_ */
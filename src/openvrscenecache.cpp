@@ -0,0 +1,260 @@
+/*
+ * openvrscenecache.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrscenecache.h"
+#include "openvrcachefile.h"
+
+#ifdef _WIN32
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <osg/Notify>
+#include <osg/Timer>
+#include <osg/Version>
+#include <osgDB/FileNameUtils>
+#include <osgDB/FileUtils>
+#include <osgDB/ReadFile>
+#include <osgDB/Registry>
+#include <osgUtil/Optimizer>
+#include <OpenThreads/ScopedLock>
+#include <istream>
+#include <streambuf>
+
+// Read only view of a whole file, memory mapped.
+class OpenVRMappedFile
+{
+public:
+    explicit OpenVRMappedFile(const std::string& path) : m_data(nullptr), m_size(0)
+    {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr)
+            {
+                // The view keeps the mapping alive.
+                m_data = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                m_size = (m_data != nullptr) ? static_cast<size_t>(size.QuadPart) : 0;
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+        {
+            return;
+        }
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+            {
+                m_data = static_cast<const char*>(data);
+                m_size = static_cast<size_t>(status.st_size);
+            }
+        }
+        close(file);
+#endif
+    }
+
+    ~OpenVRMappedFile()
+    {
+        if (m_data == nullptr)
+        {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+#else
+        munmap(const_cast<char*>(m_data), m_size);
+#endif
+    }
+
+    bool valid() const { return m_data != nullptr; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    OpenVRMappedFile(const OpenVRMappedFile&);
+    OpenVRMappedFile& operator=(const OpenVRMappedFile&);
+
+    const char* m_data;
+    size_t m_size;
+};
+
+// Lets a reader parse memory it is given as a seekable input stream, without a copy.
+class OpenVRMemoryStreamBuffer : public std::streambuf
+{
+public:
+    OpenVRMemoryStreamBuffer(const char* data, size_t size)
+    {
+        char* begin = const_cast<char*>(data);
+        setg(begin, begin, begin + size);
+    }
+
+protected:
+    virtual pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode)
+    {
+        char* origin = (direction == std::ios_base::beg) ? eback() : (direction == std::ios_base::cur) ? gptr() : egptr();
+        if (offset < eback() - origin || offset > egptr() - origin)
+        {
+            return pos_type(off_type(-1));
+        }
+        setg(eback(), origin + offset, egptr());
+        return pos_type(gptr() - eback());
+    }
+
+    virtual pos_type seekpos(pos_type position, std::ios_base::openmode mode)
+    {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+};
+
+OpenVRSceneCache::OpenVRSceneCache(const std::string& directory) :
+    m_directory(directory),
+    m_maximumSize(DEFAULT_MAXIMUM_SIZE),
+    m_hits(0),
+    m_misses(0)
+{
+    if (!m_directory.empty() && !osgDB::makeDirectory(m_directory))
+    {
+        osg::notify(osg::WARN) << "Warning: Could not create scene cache directory " << m_directory << std::endl;
+        m_directory.clear();
+    }
+}
+
+osg::ref_ptr<osg::Node> OpenVRSceneCache::read(const std::string& fileName)
+{
+    const std::string path = osgDB::findDataFile(fileName);
+    if (m_directory.empty() || path.empty())
+    {
+        return readOptimized(fileName);
+    }
+
+    osg::Timer* timer = osg::Timer::instance();
+    osg::Timer_t tick = timer->tick();
+
+    // The key also changes with the reader plugin that converts the file and the format of the cache.
+    uint64_t hash;
+    if (!OpenVRCacheFile::hashFile(path, hash))
+    {
+        osg::notify(osg::WARN) << "Warning: Could not hash " << path << ", reading it without the scene cache" << std::endl;
+        return readOptimized(fileName);
+    }
+    hash = OpenVRCacheFile::hashString(osgDB::getLowerCaseFileExtension(path), hash);
+    hash = OpenVRCacheFile::hashString(osgGetVersion(), hash);
+    const std::string cacheFile = m_directory + "/" + OpenVRCacheFile::hexString(hash) + ".osgb";
+    const double hashMs = timer->delta_m(tick, timer->tick());
+
+    if (osgDB::fileExists(cacheFile))
+    {
+        tick = timer->tick();
+        osg::ref_ptr<osg::Node> cached = readCached(cacheFile);
+        if (cached.valid())
+        {
+            // Keeps the entry from being evicted, also when other sources share it.
+            OpenVRCacheFile::touch(cacheFile);
+            {
+                OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+                ++m_hits;
+            }
+            osg::notify(osg::NOTICE) << "Scene cache hit for " << fileName << ": hashed in " << hashMs << " ms, read in "
+                                     << timer->delta_m(tick, timer->tick()) << " ms" << std::endl;
+            return cached;
+        }
+        osg::notify(osg::WARN) << "Warning: Could not read cached scene " << cacheFile << ", converting " << fileName << " again" << std::endl;
+    }
+
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        ++m_misses;
+    }
+
+    tick = timer->tick();
+    osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile(path);
+    if (!node.valid())
+    {
+        return nullptr;
+    }
+    const double readMs = timer->delta_m(tick, timer->tick());
+
+    tick = timer->tick();
+    optimize(*node);
+    const double optimizeMs = timer->delta_m(tick, timer->tick());
+
+    tick = timer->tick();
+    if (OpenVRCacheFile::writeNode(*node, cacheFile))
+    {
+        OpenVRCacheFile::evict(m_directory, m_maximumSize, cacheFile);
+    }
+    const double writeMs = timer->delta_m(tick, timer->tick());
+
+    osg::notify(osg::NOTICE) << "Scene cache miss for " << fileName << ": hashed in " << hashMs << " ms, read in " << readMs
+                             << " ms, optimized in " << optimizeMs << " ms, written in " << writeMs << " ms" << std::endl;
+    return node;
+}
+
+osg::ref_ptr<osg::Node> OpenVRSceneCache::readOptimized(const std::string& fileName)
+{
+    osg::ref_ptr<osg::Node> node = osgDB::readRefNodeFile(fileName);
+    if (node.valid())
+    {
+        optimize(*node);
+    }
+    return node;
+}
+
+unsigned int OpenVRSceneCache::hits() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_hits;
+}
+
+unsigned int OpenVRSceneCache::misses() const
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return m_misses;
+}
+
+/* Protected functions */
+void OpenVRSceneCache::optimize(osg::Node& node)
+{
+    osgUtil::Optimizer optimizer;
+    optimizer.optimize(&node, osgUtil::Optimizer::DEFAULT_OPTIMIZATIONS);
+    // Stored in the file, so the bound is known before it is computed from the geometry.
+    node.setInitialBound(node.getBound());
+}
+
+osg::ref_ptr<osg::Node> OpenVRSceneCache::readCached(const std::string& cacheFile) const
+{
+    // Parsed straight from the mapped file, the page cache is the only copy of the file.
+    OpenVRMappedFile file(cacheFile);
+    osgDB::ReaderWriter* readerWriter = osgDB::Registry::instance()->getReaderWriterForExtension("osgb");
+    if (file.valid() && readerWriter != nullptr)
+    {
+        OpenVRMemoryStreamBuffer buffer(file.data(), file.size());
+        std::istream stream(&buffer);
+        osgDB::ReaderWriter::ReadResult result = readerWriter->readNode(stream);
+        if (result.validNode())
+        {
+            return result.getNode();
+        }
+    }
+    return osgDB::readRefNodeFile(cacheFile);
+}
@@ -0,0 +1,62 @@
+/*
+ * openvrscenecache.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRSCENECACHE_H_
+#define _OSG_OPENVRSCENECACHE_H_
+
+#include <osg/Node>
+#include <osg/Referenced>
+#include <osg/ref_ptr>
+#include <OpenThreads/Mutex>
+#include <stdint.h>
+#include <string>
+
+// Keeps optimized copies of scene files in a directory as native binary .osgb files. Entries
+// are named after a hash of the source file's content, its extension and the OSG version, so
+// a changed source is a miss and is converted again, and sources with the same content share
+// an entry. On a miss the scene is read, optimized (shared state, merged geometry, ...) and
+// written with its bound and images included; on a hit the .osgb file is memory mapped and
+// parsed from memory. Once the entries take more than the maximum size, the least recently
+// used ones are removed. Only the file itself is hashed, changes to files it references, e.g.
+// the .mtl and textures of an OBJ, are not noticed. Can be used from several threads at once.
+class OpenVRSceneCache : public osg::Referenced
+{
+public:
+    static const uint64_t DEFAULT_MAXIMUM_SIZE = 1024ULL * 1024ULL * 1024ULL;
+
+    explicit OpenVRSceneCache(const std::string& directory);
+
+    // Bytes the entries may take on disk, checked whenever an entry is added.
+    void setMaximumSize(uint64_t bytes) { m_maximumSize = bytes; }
+    uint64_t maximumSize() const { return m_maximumSize; }
+
+    // Reads the scene from the cache, or from the file and adds it to the cache. Files that
+    // cannot be found on the data path, e.g. pseudo loaders, are read without the cache but
+    // optimized the same way.
+    osg::ref_ptr<osg::Node> read(const std::string& fileName);
+
+    // Reads the file and optimizes it as it is stored in the cache (shared state, merged
+    // geometry, ...) with its bound set as initial bound, for scenes read without a cache.
+    static osg::ref_ptr<osg::Node> readOptimized(const std::string& fileName);
+
+    unsigned int hits() const;
+    unsigned int misses() const;
+
+protected:
+    ~OpenVRSceneCache() {}
+
+    static void optimize(osg::Node& node);
+    osg::ref_ptr<osg::Node> readCached(const std::string& cacheFile) const;
+
+    std::string m_directory;
+    uint64_t m_maximumSize;
+
+    mutable OpenThreads::Mutex m_mutex; // guards the counters
+    unsigned int m_hits;
+    unsigned int m_misses;
+};
+
+#endif /* _OSG_OPENVRSCENECACHE_H_ */
@@ -0,0 +1,201 @@
+/*
+ * openvrsceneloader.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrsceneloader.h"
+#include "openvrsinglepassstate.h"
+
+#include <osg/Notify>
+#include <OpenThreads/ScopedLock>
+
+// Starts loading with the first update and attaches the models that are ready.
+class OpenVRSceneLoaderUpdateCallback : public osg::NodeCallback
+{
+public:
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        static_cast<OpenVRSceneLoader*>(node)->updateScene();
+        traverse(node, nv);
+    }
+};
+
+OpenVRSceneLoader::OpenVRSceneLoader(const std::vector<std::string>& fileNames, osg::Node* placeholder, unsigned int threads) :
+    osg::Group(),
+    m_placeholder(placeholder),
+    m_threadCount(osg::minimum(osg::maximum(threads, 1u), static_cast<unsigned int>(fileNames.size()))),
+    m_startTick(0),
+    m_started(false),
+    m_finished(false),
+    m_attached(0),
+    m_nextFile(0),
+    m_done(false)
+{
+    for (const std::string& fileName : fileNames)
+    {
+        Model model;
+        model.fileName = fileName;
+        model.read = false;
+        model.handled = false;
+        model.readMs = 0.0;
+        m_models.push_back(model);
+    }
+
+    if (m_placeholder.valid())
+    {
+        OpenVRSinglePassStateVisitor singlePassState;
+        m_placeholder->accept(singlePassState);
+        addChild(m_placeholder.get());
+    }
+    setUpdateCallback(new OpenVRSceneLoaderUpdateCallback);
+}
+
+OpenVRSceneLoader::~OpenVRSceneLoader()
+{
+    stop();
+}
+
+void OpenVRSceneLoader::stop()
+{
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_done = true;
+    }
+
+    for (const std::unique_ptr<LoaderThread>& thread : m_threads)
+    {
+        if (thread->isRunning())
+        {
+            thread->join();
+        }
+    }
+}
+
+void OpenVRSceneLoader::updateScene()
+{
+    start();
+    if (m_finished)
+    {
+        return;
+    }
+
+    osg::ref_ptr<osgUtil::IncrementalCompileOperation> incrementalCompile;
+    m_incrementalCompile.lock(incrementalCompile);
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    bool finished = true;
+    for (Model& model : m_models)
+    {
+        if (model.handled)
+        {
+            continue;
+        }
+        if (!model.read)
+        {
+            finished = false;
+            continue;
+        }
+
+        if (!model.node.valid())
+        {
+            osg::notify(osg::WARN) << "Warning: Could not load " << model.fileName << std::endl;
+            model.handled = true;
+            continue;
+        }
+
+        // Compiled on the graphics thread between frames, attached once that has finished.
+        if (!model.compileSet.valid() && incrementalCompile.valid())
+        {
+            model.compileSet = new osgUtil::IncrementalCompileOperation::CompileSet(model.node.get());
+            incrementalCompile->add(model.compileSet.get());
+        }
+        if (model.compileSet.valid() && !model.compileSet->compiled())
+        {
+            finished = false;
+            continue;
+        }
+
+        addChild(model.node.get());
+        model.handled = true;
+        osg::notify(osg::NOTICE) << "Loaded " << model.fileName << ": read in " << model.readMs << " ms, shown after "
+                                 << osg::Timer::instance()->delta_m(m_startTick, osg::Timer::instance()->tick()) << " ms" << std::endl;
+
+        // The placeholder goes with the first model, before the home position is computed from the scene.
+        if (m_attached++ == 0)
+        {
+            if (m_placeholder.valid())
+            {
+                removeChild(m_placeholder.get());
+            }
+            osg::ref_ptr<osgGA::CameraManipulator> manipulator;
+            if (m_manipulator.lock(manipulator))
+            {
+                manipulator->home(0.0);
+            }
+        }
+    }
+
+    if (finished)
+    {
+        m_finished = true;
+        if (m_attached == 0)
+        {
+            osg::notify(osg::WARN) << "Warning: No model could be loaded, the placeholder stays." << std::endl;
+        }
+    }
+}
+
+void OpenVRSceneLoader::start()
+{
+    if (m_started)
+    {
+        return;
+    }
+    m_started = true;
+    m_startTick = osg::Timer::instance()->tick();
+    for (unsigned int i = 0; i < m_threadCount; ++i)
+    {
+        m_threads.push_back(std::unique_ptr<LoaderThread>(new LoaderThread(this)));
+        m_threads.back()->start();
+    }
+}
+
+/* Protected functions */
+void OpenVRSceneLoader::loadFiles()
+{
+    while (true)
+    {
+        unsigned int index;
+        std::string fileName;
+        {
+            OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+            if (m_done || m_nextFile >= m_models.size())
+            {
+                return;
+            }
+            index = m_nextFile++;
+            fileName = m_models[index].fileName;
+        }
+
+        const unsigned int span = m_timeline.valid() ? m_timeline->begin("read " + fileName) : 0;
+        const osg::Timer_t startTick = osg::Timer::instance()->tick();
+        osg::ref_ptr<osg::Node> node = m_cache.valid() ? m_cache->read(fileName) : OpenVRSceneCache::readOptimized(fileName);
+        const double readMs = osg::Timer::instance()->delta_m(startTick, osg::Timer::instance()->tick());
+        if (node.valid())
+        {
+            // While no other thread uses the model's state sets.
+            OpenVRSinglePassStateVisitor singlePassState;
+            node->accept(singlePassState);
+        }
+        if (m_timeline.valid())
+        {
+            m_timeline->end(span);
+        }
+
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        m_models[index].node = node;
+        m_models[index].readMs = readMs;
+        m_models[index].read = true;
+    }
+}
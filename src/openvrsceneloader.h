@@ -0,0 +1,101 @@
+/*
+ * openvrsceneloader.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRSCENELOADER_H_
+#define _OSG_OPENVRSCENELOADER_H_
+
+#include <osg/Group>
+#include <osg/observer_ptr>
+#include <osg/Timer>
+#include <osgGA/CameraManipulator>
+#include <osgUtil/IncrementalCompileOperation>
+#include <OpenThreads/Thread>
+#include <OpenThreads/Mutex>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "openvrscenecache.h"
+#include "openvrstartuptimeline.h"
+
+// Root of the scene that loads its models while frames are already being rendered. The
+// files are read by worker threads, started by start() or else by the first update
+// traversal, and a placeholder is shown until the first model is. With an incremental
+// compile operation each model's GL objects are compiled between frames within the
+// operation's time budget and the model is attached once that has finished, so neither
+// reading nor compiling stalls a frame.
+class OpenVRSceneLoader : public osg::Group
+{
+public:
+    // Reads up to that many files at the same time.
+    OpenVRSceneLoader(const std::vector<std::string>& fileNames, osg::Node* placeholder, unsigned int threads = 4);
+
+    // Compile operation of the viewer, see osgViewer::ViewerBase::setIncrementalCompileOperation().
+    void setIncrementalCompileOperation(osgUtil::IncrementalCompileOperation* ico) { m_incrementalCompile = ico; }
+    // Moved to its home position, computed from the loaded scene, when the first model is shown.
+    void setManipulator(osgGA::CameraManipulator* manipulator) { m_manipulator = manipulator; }
+
+    // Records the reading of every file, set before start().
+    void setStartupTimeline(OpenVRStartupTimeline* timeline) { m_timeline = timeline; }
+    // Files are read through the cache, set before start().
+    void setSceneCache(OpenVRSceneCache* cache) { m_cache = cache; }
+
+    // Starts reading the files, also while the device and window are still being set up.
+    void start();
+
+    // True once every file was either attached or failed to load.
+    bool finished() const { return m_finished; }
+
+    // Returns once the worker threads have finished, the file being read is completed first.
+    void stop();
+
+    // Called by the update callback.
+    void updateScene();
+
+protected:
+    ~OpenVRSceneLoader();
+
+    class LoaderThread : public OpenThreads::Thread
+    {
+    public:
+        explicit LoaderThread(OpenVRSceneLoader* loader) : m_loader(loader) {}
+        virtual void run() { m_loader->loadFiles(); }
+    protected:
+        OpenVRSceneLoader* m_loader;
+    };
+
+    struct Model
+    {
+        std::string fileName;
+        osg::ref_ptr<osg::Node> node;
+        osg::ref_ptr<osgUtil::IncrementalCompileOperation::CompileSet> compileSet;
+        bool read;     // set by the worker that read the file
+        bool handled;  // attached or reported as failed, only used by the update thread
+        double readMs;
+    };
+
+    // Runs on the worker threads until all files are read or stop() is called.
+    void loadFiles();
+
+    osg::ref_ptr<osg::Node> m_placeholder;
+    unsigned int m_threadCount;
+    std::vector<std::unique_ptr<LoaderThread> > m_threads;
+    osg::observer_ptr<osgUtil::IncrementalCompileOperation> m_incrementalCompile;
+    osg::observer_ptr<osgGA::CameraManipulator> m_manipulator;
+    osg::ref_ptr<OpenVRStartupTimeline> m_timeline;
+    osg::ref_ptr<OpenVRSceneCache> m_cache;
+    osg::Timer_t m_startTick;
+    bool m_started;
+    bool m_finished;
+    unsigned int m_attached;
+
+    OpenThreads::Mutex m_mutex;   // guards everything below
+    std::vector<Model> m_models;
+    unsigned int m_nextFile;
+    bool m_done;
+};
+
+#endif /* _OSG_OPENVRSCENELOADER_H_ */
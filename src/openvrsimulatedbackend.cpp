@@ -0,0 +1,480 @@
+/*
+ * openvrsimulatedbackend.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrsimulatedbackend.h"
+
+#include <OpenThreads/Thread>
+#include <OpenThreads/ScopedLock>
+#include <osg/Math>
+#include <cmath>
+#include <cstring>
+
+// Field of view tangents and IPD of the simulated headset, close to a first generation Vive.
+static const float s_ipd = 0.064f;
+static const float s_tanOuter = 1.39f;
+static const float s_tanInner = 1.24f;
+static const float s_tanUp = 1.47f;
+static const float s_tanDown = 1.47f;
+static const uint32_t s_renderWidth = 1512;
+static const uint32_t s_renderHeight = 1680;
+// Radius of the visible lens area relative to the render target, larger than 0.5 so the circle is cut by the edges.
+static const float s_lensRadius = 0.56f;
+static const int s_lensSegments = 32;
+
+static vr::HmdMatrix34_t makeRigidMatrix(double yaw, double pitch, double x, double y, double z)
+{
+    const double cy = cos(yaw), sy = sin(yaw);
+    const double cp = cos(pitch), sp = sin(pitch);
+
+    // Rotation about Y (yaw) followed by X (pitch), column vector convention as in the OpenVR API
+    vr::HmdMatrix34_t mat;
+    mat.m[0][0] = float(cy);  mat.m[0][1] = float(sy * sp); mat.m[0][2] = float(sy * cp); mat.m[0][3] = float(x);
+    mat.m[1][0] = 0.0f;       mat.m[1][1] = float(cp);      mat.m[1][2] = float(-sp);     mat.m[1][3] = float(y);
+    mat.m[2][0] = float(-sy); mat.m[2][1] = float(cy * sp); mat.m[2][2] = float(cy * cp); mat.m[2][3] = float(z);
+    return mat;
+}
+
+static double wave(double amplitude, double frequency, double t)
+{
+    return amplitude * sin(2.0 * osg::PI * frequency * t);
+}
+
+/* Public functions */
+OpenVRSimulatedBackend::OpenVRSimulatedBackend(float refreshRate, bool paced) :
+    m_refreshRate(refreshRate > 0.0f ? refreshRate : 90.0f),
+    m_paced(paced),
+    m_frameIndex(0),
+    m_droppedFrames(0),
+    m_touchpadPressed(false),
+    m_nextVsync(0.0)
+{
+    m_startTick = osg::Timer::instance()->tick();
+    m_lastPosesTick = m_startTick;
+    m_lastSubmitTick = m_startTick;
+
+    std::memset(m_timing.data(), 0, sizeof(vr::Compositor_FrameTiming) * m_timing.size());
+
+    for (vr::TrackedDeviceIndex_t i = 0; i < DEVICE_COUNT; ++i)
+    {
+        queueEvent(vr::VREvent_TrackedDeviceActivated, i);
+    }
+
+    // Hidden area outside a round lens centered in the render target. Each segment of the
+    // circle is connected to the render target edge in the same direction. Segment ends
+    // include the diagonals so the outer points of a segment are always on the same edge.
+    auto edgePoint = [](double angle, double radius)
+    {
+        const double dx = cos(angle), dy = sin(angle);
+        const double toEdge = 0.5 / osg::maximum(fabs(dx), fabs(dy));
+        const double r = osg::minimum(radius, toEdge);
+        vr::HmdVector2_t v;
+        v.v[0] = float(0.5 + dx * r);
+        v.v[1] = float(0.5 + dy * r);
+        return v;
+    };
+
+    for (int i = 0; i < s_lensSegments; ++i)
+    {
+        const double a0 = 2.0 * osg::PI * i / s_lensSegments;
+        const double a1 = 2.0 * osg::PI * (i + 1) / s_lensSegments;
+        const vr::HmdVector2_t inner0 = edgePoint(a0, s_lensRadius), inner1 = edgePoint(a1, s_lensRadius);
+        const vr::HmdVector2_t outer0 = edgePoint(a0, 1.0), outer1 = edgePoint(a1, 1.0);
+
+        const vr::HmdVector2_t triangles[6] = { inner0, outer0, outer1, inner0, outer1, inner1 };
+        m_hiddenAreaVertices.insert(m_hiddenAreaVertices.end(), triangles, triangles + 6);
+    }
+}
+
+std::string OpenVRSimulatedBackend::trackedDeviceProperty(vr::TrackedDeviceIndex_t index, vr::TrackedDeviceProperty prop)
+{
+    switch (prop)
+    {
+        case vr::Prop_TrackingSystemName_String:
+            return "simulated";
+        case vr::Prop_SerialNumber_String:
+            return "SIM-000" + std::to_string(index);
+        case vr::Prop_RenderModelName_String:
+            return (index == HMD) ? "generic_hmd" : "vr_controller_vive_1_5";
+        default:
+            return "";
+    }
+}
+
+void OpenVRSimulatedBackend::recommendedRenderTargetSize(uint32_t& width, uint32_t& height)
+{
+    width = s_renderWidth;
+    height = s_renderHeight;
+}
+
+vr::HmdMatrix44_t OpenVRSimulatedBackend::projectionMatrix(vr::EVREye eye, float nearClip, float farClip)
+{
+    // Outer edge of each eye is wider than the inner edge, as on real headsets.
+    const float left = (eye == vr::Eye_Left) ? -s_tanOuter : -s_tanInner;
+    const float right = (eye == vr::Eye_Left) ? s_tanInner : s_tanOuter;
+    const float bottom = -s_tanDown;
+    const float top = s_tanUp;
+
+    vr::HmdMatrix44_t mat;
+    std::memset(&mat, 0, sizeof(mat));
+    mat.m[0][0] = 2.0f / (right - left);
+    mat.m[0][2] = (right + left) / (right - left);
+    mat.m[1][1] = 2.0f / (top - bottom);
+    mat.m[1][2] = (top + bottom) / (top - bottom);
+    mat.m[2][2] = -(farClip + nearClip) / (farClip - nearClip);
+    mat.m[2][3] = -2.0f * farClip * nearClip / (farClip - nearClip);
+    mat.m[3][2] = -1.0f;
+    return mat;
+}
+
+vr::HmdMatrix34_t OpenVRSimulatedBackend::eyeToHeadTransform(vr::EVREye eye)
+{
+    return makeRigidMatrix(0.0, 0.0, (eye == vr::Eye_Left) ? -0.5 * s_ipd : 0.5 * s_ipd, 0.0, 0.0);
+}
+
+vr::HiddenAreaMesh_t OpenVRSimulatedBackend::hiddenAreaMesh(vr::EVREye)
+{
+    vr::HiddenAreaMesh_t mesh;
+    mesh.pVertexData = m_hiddenAreaVertices.data();
+    mesh.unTriangleCount = uint32_t(m_hiddenAreaVertices.size() / 3);
+    return mesh;
+}
+
+vr::ETrackedDeviceClass OpenVRSimulatedBackend::trackedDeviceClass(vr::TrackedDeviceIndex_t index)
+{
+    switch (index)
+    {
+        case HMD:
+            return vr::TrackedDeviceClass_HMD;
+        case RIGHT_CONTROLLER:
+        case LEFT_CONTROLLER:
+            return vr::TrackedDeviceClass_Controller;
+        default:
+            return vr::TrackedDeviceClass_Invalid;
+    }
+}
+
+vr::ETrackedControllerRole OpenVRSimulatedBackend::controllerRole(vr::TrackedDeviceIndex_t index)
+{
+    switch (index)
+    {
+        case RIGHT_CONTROLLER:
+            return vr::TrackedControllerRole_RightHand;
+        case LEFT_CONTROLLER:
+            return vr::TrackedControllerRole_LeftHand;
+        default:
+            return vr::TrackedControllerRole_Invalid;
+    }
+}
+
+bool OpenVRSimulatedBackend::controllerState(vr::TrackedDeviceIndex_t index, vr::VRControllerState_t& state)
+{
+    std::memset(&state, 0, sizeof(state));
+    if (trackedDeviceClass(index) != vr::TrackedDeviceClass_Controller)
+    {
+        return false;
+    }
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    const double t = simulatedTime();
+    state.unPacketNum = m_frameIndex;
+
+    // Thumb circles slowly around the touchpad of the right controller while it is pressed.
+    if (index == RIGHT_CONTROLLER && m_touchpadPressed)
+    {
+        state.ulButtonPressed = vr::ButtonMaskFromId(vr::k_EButton_SteamVR_Touchpad);
+        state.ulButtonTouched = state.ulButtonPressed;
+        state.rAxis[0].x = float(cos(2.0 * osg::PI * 0.25 * t));
+        state.rAxis[0].y = float(sin(2.0 * osg::PI * 0.25 * t));
+    }
+    return true;
+}
+
+bool OpenVRSimulatedBackend::pollNextEvent(vr::VREvent_t& event)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    if (m_events.empty())
+    {
+        return false;
+    }
+
+    event = m_events.front();
+    m_events.pop_front();
+    return true;
+}
+
+bool OpenVRSimulatedBackend::waitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count)
+{
+    osg::Timer* timer = osg::Timer::instance();
+    const osg::Timer_t callTick = timer->tick();
+    const double vsyncInterval = 1.0 / m_refreshRate;
+
+    // Only this call changes the vsync clock and the frame index, so they are read without the lock.
+    uint32_t droppedFrames = 0;
+    double nextVsync = m_nextVsync;
+    if (m_paced)
+    {
+        // Block until the next vsync; when the frame took longer than one interval
+        // the missed vsyncs are reported as dropped frames.
+        double now = timer->delta_s(m_startTick, callTick);
+        if (m_frameIndex == 0)
+        {
+            // Start the vsync clock with the first frame, not at construction.
+            nextVsync = now;
+        }
+        else if (now < nextVsync)
+        {
+            OpenThreads::Thread::microSleep(static_cast<unsigned int>((nextVsync - now) * 1.0e6));
+        }
+        else
+        {
+            droppedFrames = static_cast<uint32_t>((now - nextVsync) / vsyncInterval);
+            nextVsync += droppedFrames * vsyncInterval;
+        }
+        nextVsync += vsyncInterval;
+    }
+
+    const osg::Timer_t posesTick = timer->tick();
+
+    // The poses may be waited for on another thread than the one submitting and polling events.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    m_nextVsync = nextVsync;
+
+    // Close the timing record of the frame that has just been submitted.
+    if (m_frameIndex > 0)
+    {
+        vr::Compositor_FrameTiming& timing = m_timing[(m_frameIndex - 1) % TIMING_HISTORY];
+        timing.m_nSize = sizeof(vr::Compositor_FrameTiming);
+        timing.m_nFrameIndex = m_frameIndex - 1;
+        timing.m_nNumFramePresents = 1;
+        timing.m_nNumDroppedFrames = droppedFrames;
+        timing.m_flSystemTimeInSeconds = timer->delta_s(m_startTick, m_lastPosesTick);
+        timing.m_flClientFrameIntervalMs = float(timer->delta_m(m_lastPosesTick, posesTick));
+        timing.m_flSubmitFrameMs = float(timer->delta_m(m_lastPosesTick, m_lastSubmitTick));
+        timing.m_flWaitGetPosesCalledMs = float(timer->delta_m(m_lastPosesTick, callTick));
+        timing.m_flNewPosesReadyMs = float(timer->delta_m(m_lastPosesTick, posesTick));
+    }
+    m_droppedFrames += droppedFrames;
+    m_lastPosesTick = posesTick;
+
+    ++m_frameIndex;
+    const double t = simulatedTime();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        vr::TrackedDevicePose_t& pose = poses[i];
+        std::memset(&pose, 0, sizeof(pose));
+        if (i >= DEVICE_COUNT)
+        {
+            continue;
+        }
+
+        pose.mDeviceToAbsoluteTracking = scriptedPose(i, t);
+        pose.eTrackingResult = vr::TrackingResult_Running_OK;
+        pose.bPoseIsValid = true;
+        pose.bDeviceIsConnected = true;
+
+        // Velocity from the previous scripted sample, as the script is smooth this is close enough.
+        const vr::HmdMatrix34_t previous = scriptedPose(i, t - vsyncInterval);
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            pose.vVelocity.v[axis] = (pose.mDeviceToAbsoluteTracking.m[axis][3] - previous.m[axis][3]) * m_refreshRate;
+        }
+    }
+
+    // Scripted touchpad input on the right controller
+    bool touchpadPressed = scriptedTouchpadPressed(t);
+    if (touchpadPressed != m_touchpadPressed)
+    {
+        m_touchpadPressed = touchpadPressed;
+        queueEvent(touchpadPressed ? vr::VREvent_ButtonPress : vr::VREvent_ButtonUnpress, RIGHT_CONTROLLER, vr::k_EButton_SteamVR_Touchpad);
+    }
+
+    return true;
+}
+
+bool OpenVRSimulatedBackend::submit(vr::EVREye, const vr::Texture_t& texture, const vr::VRTextureBounds_t*)
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    m_lastSubmitTick = osg::Timer::instance()->tick();
+    return texture.handle != nullptr;
+}
+
+bool OpenVRSimulatedBackend::frameTiming(vr::Compositor_FrameTiming& timing, uint32_t framesAgo)
+{
+    // Only frames that have been closed by a following waitGetPoses() have a timing record.
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    if (framesAgo + 1 >= m_frameIndex || framesAgo >= TIMING_HISTORY)
+    {
+        return false;
+    }
+
+    timing = m_timing[(m_frameIndex - 2 - framesAgo) % TIMING_HISTORY];
+    return true;
+}
+
+bool OpenVRSimulatedBackend::devicePoses(vr::TrackedDevicePose_t* poses, uint32_t count, float secondsFromNow)
+{
+    double t = 0.0;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        // The last poses were those of the coming vsync, now is that long before it.
+        t = simulatedTime() - photonDelay() + secondsFromNow;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        vr::TrackedDevicePose_t& pose = poses[i];
+        std::memset(&pose, 0, sizeof(pose));
+        if (i >= DEVICE_COUNT)
+        {
+            continue;
+        }
+
+        pose.mDeviceToAbsoluteTracking = scriptedPose(i, t);
+        pose.eTrackingResult = vr::TrackingResult_Running_OK;
+        pose.bPoseIsValid = true;
+        pose.bDeviceIsConnected = true;
+    }
+    return true;
+}
+
+float OpenVRSimulatedBackend::secondsToPhotons()
+{
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    return float(photonDelay());
+}
+
+// Render model data owned by the simulated backend until it is freed.
+struct SimulatedRenderModel : public vr::RenderModel_t
+{
+    std::vector<vr::RenderModel_Vertex_t> vertices;
+    std::vector<uint16_t> indices;
+};
+
+struct SimulatedTextureMap : public vr::RenderModel_TextureMap_t
+{
+    std::vector<uint8_t> pixels;
+};
+
+vr::EVRRenderModelError OpenVRSimulatedBackend::loadRenderModel(const std::string&, vr::RenderModel_t** model)
+{
+    // A box of 4 x 3 x 16 cm pointing along -z, four vertices per face for flat normals.
+    const float size[3] = { 0.02f, 0.015f, 0.08f };
+    SimulatedRenderModel* box = new SimulatedRenderModel;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        for (int side = -1; side <= 1; side += 2)
+        {
+            const int u = (axis + 1) % 3;
+            const int v = (axis + 2) % 3;
+            const uint16_t first = uint16_t(box->vertices.size());
+            for (int corner = 0; corner < 4; ++corner)
+            {
+                const float cu = (corner == 1 || corner == 2) ? 1.0f : -1.0f;
+                const float cv = (corner >= 2) ? 1.0f : -1.0f;
+                vr::RenderModel_Vertex_t vertex;
+                std::memset(&vertex, 0, sizeof(vertex));
+                vertex.vPosition.v[axis] = side * size[axis];
+                vertex.vPosition.v[u] = cu * size[u];
+                vertex.vPosition.v[v] = side * cv * size[v];
+                vertex.vNormal.v[axis] = float(side);
+                vertex.rfTextureCoord[0] = 0.5f * (cu + 1.0f);
+                vertex.rfTextureCoord[1] = 0.5f * (cv + 1.0f);
+                box->vertices.push_back(vertex);
+            }
+            const uint16_t quad[6] = { 0, 1, 2, 0, 2, 3 };
+            for (uint16_t index : quad)
+            {
+                box->indices.push_back(uint16_t(first + index));
+            }
+        }
+    }
+
+    box->rVertexData = box->vertices.data();
+    box->unVertexCount = uint32_t(box->vertices.size());
+    box->rIndexData = box->indices.data();
+    box->unTriangleCount = uint32_t(box->indices.size() / 3);
+    box->diffuseTextureId = 0;
+    *model = box;
+    return vr::VRRenderModelError_None;
+}
+
+void OpenVRSimulatedBackend::freeRenderModel(vr::RenderModel_t* model)
+{
+    delete static_cast<SimulatedRenderModel*>(model);
+}
+
+vr::EVRRenderModelError OpenVRSimulatedBackend::loadRenderModelTexture(vr::TextureID_t, vr::RenderModel_TextureMap_t** texture)
+{
+    SimulatedTextureMap* checker = new SimulatedTextureMap;
+    checker->unWidth = 8;
+    checker->unHeight = 8;
+    for (int y = 0; y < checker->unHeight; ++y)
+    {
+        for (int x = 0; x < checker->unWidth; ++x)
+        {
+            const uint8_t grey = ((x + y) % 2 == 0) ? 200 : 90;
+            const uint8_t rgba[4] = { grey, grey, grey, 255 };
+            checker->pixels.insert(checker->pixels.end(), rgba, rgba + 4);
+        }
+    }
+    checker->rubTextureMapData = checker->pixels.data();
+    *texture = checker;
+    return vr::VRRenderModelError_None;
+}
+
+void OpenVRSimulatedBackend::freeRenderModelTexture(vr::RenderModel_TextureMap_t* texture)
+{
+    delete static_cast<SimulatedTextureMap*>(texture);
+}
+
+/* Protected functions */
+double OpenVRSimulatedBackend::photonDelay() const
+{
+    // A frame is displayed at the vsync following the last waitGetPoses(), unpaced frames at once.
+    if (!m_paced || m_frameIndex == 0)
+    {
+        return 0.0;
+    }
+    const double now = osg::Timer::instance()->delta_s(m_startTick, osg::Timer::instance()->tick());
+    return osg::maximum(m_nextVsync - now, 0.0);
+}
+
+vr::HmdMatrix34_t OpenVRSimulatedBackend::scriptedPose(vr::TrackedDeviceIndex_t index, double t) const
+{
+    switch (index)
+    {
+        case HMD:
+            // Looking around while slightly swaying the head
+            return makeRigidMatrix(osg::DegreesToRadians(wave(30.0, 0.1, t)),
+                                   osg::DegreesToRadians(wave(10.0, 0.17, t)),
+                                   wave(0.05, 0.2, t), wave(0.02, 0.3, t), wave(0.03, 0.13, t));
+        case RIGHT_CONTROLLER:
+            return makeRigidMatrix(0.0, osg::DegreesToRadians(wave(20.0, 0.4, t)),
+                                   0.25 + wave(0.1, 0.5, t + 0.5), -0.3 + wave(0.1, 0.5, t), -0.4);
+        case LEFT_CONTROLLER:
+            return makeRigidMatrix(0.0, osg::DegreesToRadians(wave(20.0, 0.3, t)),
+                                   -0.25 + wave(0.1, 0.35, t + 0.5), -0.3 + wave(0.1, 0.35, t), -0.4);
+        default:
+            return makeRigidMatrix(0.0, 0.0, 0.0, 0.0, 0.0);
+    }
+}
+
+bool OpenVRSimulatedBackend::scriptedTouchpadPressed(double t) const
+{
+    // Pressed for one second out of every four
+    return fmod(t, 4.0) >= 1.0 && fmod(t, 4.0) < 2.0;
+}
+
+void OpenVRSimulatedBackend::queueEvent(vr::EVREventType type, vr::TrackedDeviceIndex_t index, uint32_t button)
+{
+    vr::VREvent_t event;
+    std::memset(&event, 0, sizeof(event));
+    event.eventType = type;
+    event.trackedDeviceIndex = index;
+    event.data.controller.button = button;
+    m_events.push_back(event);
+}
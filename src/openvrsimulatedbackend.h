@@ -0,0 +1,115 @@
+/*
+ * openvrsimulatedbackend.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRSIMULATEDBACKEND_H_
+#define _OSG_OPENVRSIMULATEDBACKEND_H_
+
+#include <osg/Timer>
+#include <OpenThreads/Mutex>
+#include <array>
+#include <deque>
+#include <vector>
+
+#include "openvrbackend.h"
+
+// Deterministic stand-in for the OpenVR runtime. Head and controller motion
+// is a function of the simulated frame index only, so every run renders the
+// same poses. When paced, waitGetPoses() blocks until the next vsync of the
+// simulated display (90 or 120 Hz), otherwise it returns immediately and the
+// frame loop runs as fast as it can.
+class OpenVRSimulatedBackend : public OpenVRBackend
+{
+public:
+    enum Devices
+    {
+        HMD = vr::k_unTrackedDeviceIndex_Hmd,
+        RIGHT_CONTROLLER = 1,
+        LEFT_CONTROLLER = 2,
+        DEVICE_COUNT = 3
+    };
+
+    explicit OpenVRSimulatedBackend(float refreshRate = 90.0f, bool paced = true);
+
+    virtual bool initialized() const { return true; }
+    virtual void shutdown() {}
+
+    virtual std::string trackedDeviceProperty(vr::TrackedDeviceIndex_t index, vr::TrackedDeviceProperty prop);
+    virtual float displayFrequency() { return m_refreshRate; }
+
+    virtual void recommendedRenderTargetSize(uint32_t& width, uint32_t& height);
+    virtual vr::HmdMatrix44_t projectionMatrix(vr::EVREye eye, float nearClip, float farClip);
+    virtual vr::HmdMatrix34_t eyeToHeadTransform(vr::EVREye eye);
+    virtual void resetSeatedZeroPose() {}
+    virtual vr::HiddenAreaMesh_t hiddenAreaMesh(vr::EVREye eye);
+
+    virtual bool isTrackedDeviceConnected(vr::TrackedDeviceIndex_t index) { return index < DEVICE_COUNT; }
+    virtual vr::ETrackedDeviceClass trackedDeviceClass(vr::TrackedDeviceIndex_t index);
+    virtual vr::ETrackedControllerRole controllerRole(vr::TrackedDeviceIndex_t index);
+    virtual bool controllerState(vr::TrackedDeviceIndex_t index, vr::VRControllerState_t& state);
+    virtual bool pollNextEvent(vr::VREvent_t& event);
+
+    virtual void setTrackingSpace(vr::ETrackingUniverseOrigin) {}
+    virtual bool waitGetPoses(vr::TrackedDevicePose_t* poses, uint32_t count);
+    virtual bool submit(vr::EVREye eye, const vr::Texture_t& texture, const vr::VRTextureBounds_t* bounds = nullptr);
+    virtual bool frameTiming(vr::Compositor_FrameTiming& timing, uint32_t framesAgo = 0);
+
+    // Scripted poses at the simulated time of the coming vsync, less the time still left until it.
+    virtual bool devicePoses(vr::TrackedDevicePose_t* poses, uint32_t count, float secondsFromNow);
+    virtual float secondsToPhotons();
+
+    // There is no compositor output, mirrors show the eye buffers.
+    virtual bool mirrorTexture(vr::EVREye, vr::glUInt_t&, vr::glSharedTextureHandle_t&) { return false; }
+    virtual void releaseMirrorTexture(vr::glUInt_t, vr::glSharedTextureHandle_t) {}
+    virtual void lockMirrorTexture(vr::glSharedTextureHandle_t) {}
+    virtual void unlockMirrorTexture(vr::glSharedTextureHandle_t) {}
+
+    // Every model is a box the size of a controller with a checkered texture.
+    virtual vr::EVRRenderModelError loadRenderModel(const std::string& name, vr::RenderModel_t** model);
+    virtual void freeRenderModel(vr::RenderModel_t* model);
+    virtual vr::EVRRenderModelError loadRenderModelTexture(vr::TextureID_t id, vr::RenderModel_TextureMap_t** texture);
+    virtual void freeRenderModelTexture(vr::RenderModel_TextureMap_t* texture);
+    // The box only changes with this code.
+    virtual std::string renderModelVersion(const std::string&) { return "simulated box 1"; }
+
+    uint32_t frameIndex() const { return m_frameIndex; }
+    double simulatedTime() const { return m_frameIndex / double(m_refreshRate); }
+
+protected:
+    ~OpenVRSimulatedBackend() {}
+
+    // Scripted device-to-tracking transform of a device at simulated time t.
+    // Override to replay recorded motion instead of the built-in script.
+    virtual vr::HmdMatrix34_t scriptedPose(vr::TrackedDeviceIndex_t index, double t) const;
+    virtual bool scriptedTouchpadPressed(double t) const;
+
+    // Seconds until the coming vsync, called with m_mutex held.
+    double photonDelay() const;
+
+    // Called with m_mutex held.
+    void queueEvent(vr::EVREventType type, vr::TrackedDeviceIndex_t index, uint32_t button = 0);
+
+    static const uint32_t TIMING_HISTORY = 128;
+
+    float m_refreshRate;
+    bool m_paced;
+    uint32_t m_frameIndex;
+    uint32_t m_droppedFrames;
+    bool m_touchpadPressed;
+    double m_nextVsync;
+
+    osg::Timer_t m_startTick;
+    osg::Timer_t m_lastPosesTick;
+    osg::Timer_t m_lastSubmitTick;
+
+    std::vector<vr::HmdVector2_t> m_hiddenAreaVertices;
+
+    // waitGetPoses() may run on a pose thread, this guards what it shares with the render and input calls.
+    OpenThreads::Mutex m_mutex;
+    std::deque<vr::VREvent_t> m_events;
+    std::array<vr::Compositor_FrameTiming, TIMING_HISTORY> m_timing;
+};
+
+#endif /* _OSG_OPENVRSIMULATEDBACKEND_H_ */
@@ -0,0 +1,46 @@
+/*
+ * openvrsinglepassstate.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrsinglepassstate.h"
+
+#include <osg/Geode>
+#include <osg/Material>
+
+void OpenVRSinglePassStateVisitor::apply(osg::Node& node)
+{
+    applyStateSet(node.getStateSet());
+    traverse(node);
+}
+
+void OpenVRSinglePassStateVisitor::apply(osg::Geode& geode)
+{
+    // Drawables are not visited as nodes by every OSG version.
+    applyStateSet(geode.getStateSet());
+    for (unsigned int i = 0; i < geode.getNumDrawables(); ++i)
+    {
+        applyStateSet(geode.getDrawable(i)->getStateSet());
+    }
+}
+
+void OpenVRSinglePassStateVisitor::applyStateSet(osg::StateSet* stateSet)
+{
+    if (stateSet == nullptr)
+    {
+        return;
+    }
+
+    const osg::StateAttribute::GLModeValue lighting = stateSet->getMode(GL_LIGHTING);
+    if (lighting != osg::StateAttribute::INHERIT)
+    {
+        stateSet->getOrCreateUniform("osgvr_Lighting", osg::Uniform::BOOL)->set((lighting & osg::StateAttribute::ON) != 0);
+    }
+
+    const osg::Material* material = dynamic_cast<const osg::Material*>(stateSet->getAttribute(osg::StateAttribute::MATERIAL));
+    if (material != nullptr)
+    {
+        stateSet->getOrCreateUniform("osgvr_ColorMaterial", osg::Uniform::BOOL)->set(material->getColorMode() != osg::Material::OFF);
+    }
+}
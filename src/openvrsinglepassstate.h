@@ -0,0 +1,30 @@
+/*
+ * openvrsinglepassstate.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRSINGLEPASSSTATE_H_
+#define _OSG_OPENVRSINGLEPASSSTATE_H_
+
+#include <osg/NodeVisitor>
+#include <osg/StateSet>
+
+// The single pass stereo program shades like the fixed function pipeline with one light, but
+// a shader cannot see whether GL_LIGHTING is enabled or whether osg::Material takes its colors
+// from the vertices. This visitor mirrors both into the uniforms osgvr_Lighting and
+// osgvr_ColorMaterial on every state set that sets them. Other stereo modes ignore the
+// uniforms, so it can be applied to any subgraph, before it is attached to the scene.
+class OpenVRSinglePassStateVisitor : public osg::NodeVisitor
+{
+public:
+    OpenVRSinglePassStateVisitor() : osg::NodeVisitor(osg::NodeVisitor::TRAVERSE_ALL_CHILDREN) {}
+
+    virtual void apply(osg::Node& node);
+    virtual void apply(osg::Geode& geode);
+
+    // Sets the uniforms of one state set, e.g. of a subgraph created in code.
+    static void applyStateSet(osg::StateSet* stateSet);
+};
+
+#endif /* _OSG_OPENVRSINGLEPASSSTATE_H_ */
@@ -0,0 +1,73 @@
+/*
+ * openvrstartuptimeline.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrstartuptimeline.h"
+
+#include <OpenThreads/ScopedLock>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+// Characters of the bar for the whole start.
+static const unsigned int s_barWidth = 40;
+
+OpenVRStartupTimeline::OpenVRStartupTimeline() :
+    m_startTick(osg::Timer::instance()->tick())
+{
+}
+
+unsigned int OpenVRStartupTimeline::begin(const std::string& name)
+{
+    const double startMs = osg::Timer::instance()->delta_m(m_startTick, osg::Timer::instance()->tick());
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    Span span = { name, startMs, -1.0 };
+    m_spans.push_back(span);
+    return static_cast<unsigned int>(m_spans.size() - 1);
+}
+
+void OpenVRStartupTimeline::end(unsigned int span)
+{
+    const double endMs = osg::Timer::instance()->delta_m(m_startTick, osg::Timer::instance()->tick());
+
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    m_spans[span].endMs = endMs;
+}
+
+void OpenVRStartupTimeline::print(std::ostream& out) const
+{
+    const double nowMs = osg::Timer::instance()->delta_m(m_startTick, osg::Timer::instance()->tick());
+    const double scale = s_barWidth / std::max(nowMs, 1.0);
+
+    std::vector<Span> spans;
+    {
+        OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+        spans = m_spans;
+    }
+
+    size_t nameWidth = 0;
+    for (const Span& span : spans)
+    {
+        nameWidth = std::max(nameWidth, span.name.size());
+    }
+
+    // Formatted locally, the flags and precision would otherwise stay set on the caller's stream.
+    std::ostringstream text;
+    text << "Startup timeline, " << std::fixed << std::setprecision(1) << nowMs << " ms:" << std::endl;
+    for (const Span& span : spans)
+    {
+        const bool running = span.endMs < 0.0;
+        const double endMs = running ? nowMs : span.endMs;
+        const unsigned int barStart = static_cast<unsigned int>(span.startMs * scale);
+        const unsigned int barEnd = std::max(static_cast<unsigned int>(endMs * scale), barStart + 1);
+
+        text << "  " << std::left << std::setw(static_cast<int>(nameWidth)) << span.name << std::right
+             << std::setw(9) << span.startMs << " +" << std::setw(8) << endMs - span.startMs << " ms  |"
+             << std::string(barStart, ' ') << std::string(std::min(barEnd, s_barWidth) - barStart, '#')
+             << std::string(s_barWidth - std::min(barEnd, s_barWidth), ' ') << "|" << (running ? " running" : "") << std::endl;
+    }
+    out << text.str() << std::flush;
+}
@@ -0,0 +1,47 @@
+/*
+ * openvrstartuptimeline.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRSTARTUPTIMELINE_H_
+#define _OSG_OPENVRSTARTUPTIMELINE_H_
+
+#include <osg/Referenced>
+#include <osg/Timer>
+#include <OpenThreads/Mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Records when the steps of the application start begin and end, on whichever thread they
+// run, and prints them on one time axis so overlapping steps can be seen side by side.
+class OpenVRStartupTimeline : public osg::Referenced
+{
+public:
+    // Times are relative to the construction of the timeline.
+    OpenVRStartupTimeline();
+
+    // Returns the span to pass to end(). Both can be called from any thread.
+    unsigned int begin(const std::string& name);
+    void end(unsigned int span);
+
+    // One line per span with its start, duration and a bar, spans still running are marked.
+    void print(std::ostream& out) const;
+
+protected:
+    ~OpenVRStartupTimeline() {}
+
+    struct Span
+    {
+        std::string name;
+        double startMs;
+        double endMs; // negative while running
+    };
+
+    osg::Timer_t m_startTick;
+    mutable OpenThreads::Mutex m_mutex; // guards m_spans
+    std::vector<Span> m_spans;
+};
+
+#endif /* _OSG_OPENVRSTARTUPTIMELINE_H_ */
@@ -0,0 +1,97 @@
+/*
+ * openvrstereorenderstage.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include "openvrstereorenderstage.h"
+
+#include <osgUtil/CullVisitor>
+
+/* Public functions */
+OpenVRStereoRenderStage::OpenVRStereoRenderStage(OpenVRDevice* device) :
+    osgUtil::RenderStage(),
+    m_device(device)
+{
+    m_eyeViewport[OpenVRDevice::LEFT] = new osg::Viewport;
+    m_eyeViewport[OpenVRDevice::RIGHT] = new osg::Viewport;
+}
+
+void OpenVRStereoRenderStage::drawImplementation(osg::RenderInfo& renderInfo, osgUtil::RenderLeaf*& previous)
+{
+    osg::ref_ptr<OpenVRDevice> device;
+    if (!m_device.lock(device) || !m_cameraProjection.valid())
+    {
+        osgUtil::RenderStage::drawImplementation(renderInfo, previous);
+        return;
+    }
+
+    osg::State& state = *renderInfo.getState();
+    const osg::Matrix cameraProjection = *m_cameraProjection;
+    const osg::Matrix apexToHead = osg::Matrix::inverse(device->viewMatrixCombined());
+    // The late latch correction goes in front of the eye projections, no shader is needed.
+    const osg::Matrix lateLatch = device->lateLatch() ? device->lateLatchCorrection(device->viewMatrixCombined()) : osg::Matrix::identity();
+
+    osg::ref_ptr<osg::Viewport> viewport = getViewport();
+
+    for (int i = 0; i < OpenVRDevice::COUNT; ++i)
+    {
+        OpenVRDevice::Eye eye = static_cast<OpenVRDevice::Eye>(i);
+        OpenVRTextureBuffer* buffer = device->textureBuffer(eye);
+        if (buffer == nullptr)
+        {
+            continue;
+        }
+
+        // The camera's leaves all refer to its projection matrix, update it in place.
+        const osg::Matrix eyeProjection = (eye == OpenVRDevice::LEFT)
+            ? lateLatch * apexToHead * device->viewMatrixLeft() * device->projectionMatrixLeft()
+            : lateLatch * apexToHead * device->viewMatrixRight() * device->projectionMatrixRight();
+        m_cameraProjection->set(eyeProjection);
+        // Same RefMatrix pointer as in the previous pass, force State to apply it again.
+        state.applyProjectionMatrix(nullptr);
+
+        const osg::Viewport* eyeViewport = device->eyeViewport(eye);
+        m_eyeViewport[eye]->setViewport(eyeViewport->x(), eyeViewport->y(), eyeViewport->width(), eyeViewport->height());
+
+        // With an eye atlas the shared buffer is started by the left eye and resolved after the right one.
+        const bool atlas = (device->textureBuffer(OpenVRDevice::LEFT) == device->textureBuffer(OpenVRDevice::RIGHT));
+        if (!atlas || eye == OpenVRDevice::LEFT)
+        {
+            buffer->onPreRender(renderInfo);
+        }
+        else
+        {
+            buffer->bind(renderInfo);
+        }
+
+        device->beginEyePass(renderInfo, eye, getClearColor());
+        setViewport(m_eyeViewport[eye].get());
+        osgUtil::RenderStage::drawImplementation(renderInfo, previous);
+
+        if (!atlas || eye == OpenVRDevice::RIGHT)
+        {
+            buffer->onPostRender(renderInfo);
+        }
+
+        // Leaves must not be skipped as "already applied" in the next pass.
+        previous = nullptr;
+    }
+
+    m_cameraProjection->set(cameraProjection);
+    state.applyProjectionMatrix(nullptr);
+    setViewport(viewport.get());
+}
+
+void OpenVRStereoCullCallback::operator()(osg::Node* node, osg::NodeVisitor* nv)
+{
+    // Called by the scene view with the camera's projection on top of the stack.
+    osgUtil::CullVisitor* cv = dynamic_cast<osgUtil::CullVisitor*>(nv);
+    OpenVRStereoRenderStage* stage = cv != nullptr ? dynamic_cast<OpenVRStereoRenderStage*>(cv->getRenderStage()) : nullptr;
+    if (stage != nullptr)
+    {
+        stage->setCameraProjection(cv->getProjectionMatrix());
+    }
+
+    traverse(node, nv);
+}
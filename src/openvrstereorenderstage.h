@@ -0,0 +1,44 @@
+/*
+ * openvrstereorenderstage.h
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#ifndef _OSG_OPENVRSTEREORENDERSTAGE_H_
+#define _OSG_OPENVRSTEREORENDERSTAGE_H_
+
+#include <osgUtil/RenderStage>
+
+#include "openvrdevice.h"
+
+// Render stage of the shared cull camera. The render graph is culled once with
+// the combined frustum of both eyes and then drawn twice, each time into the
+// eye's texture buffer with the projection of that eye.
+class OpenVRStereoRenderStage : public osgUtil::RenderStage
+{
+public:
+    explicit OpenVRStereoRenderStage(OpenVRDevice* device);
+
+    virtual void drawImplementation(osg::RenderInfo& renderInfo, osgUtil::RenderLeaf*& previous);
+
+    // Projection matrix the shared camera was culled with, set by OpenVRStereoCullCallback.
+    void setCameraProjection(osg::RefMatrix* projection) { m_cameraProjection = projection; }
+
+protected:
+    ~OpenVRStereoRenderStage() {}
+
+    osg::observer_ptr<OpenVRDevice> m_device;
+    osg::ref_ptr<osg::RefMatrix> m_cameraProjection; // shared by all leaves culled by the camera itself
+    osg::ref_ptr<osg::Viewport> m_eyeViewport[2];
+};
+
+// Cull callback of the shared cull camera. Tags the projection matrix the camera is culled
+// with for its OpenVRStereoRenderStage. Nested cameras and projection nodes push matrices
+// of their own, so only the camera's leaves are drawn with the eye projections.
+class OpenVRStereoCullCallback : public osg::NodeCallback
+{
+public:
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv);
+};
+
+#endif /* _OSG_OPENVRSTEREORENDERSTAGE_H_ */
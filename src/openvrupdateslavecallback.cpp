@@ -9,15 +9,24 @@
 
 void OpenVRUpdateSlaveCallback::updateSlave(osg::View& view, osg::View::Slave& slave)
 {
-    osg::Vec3 position = m_device->position();
-    osg::Quat orientation = m_device->orientation();
+    // Both eyes use the pose taken when the frame began, the pose thread may have received a newer one by now.
+    const OpenVRFrameState& frame = m_device->frameState();
 
-    osg::Matrix viewOffset = (m_cameraType == LEFT_CAMERA) ? m_device->viewMatrixLeft() : m_device->viewMatrixRight();
+    osg::Matrix viewOffset;
+    if (m_cameraType == LEFT_CAMERA)
+    {
+        viewOffset = m_device->viewMatrixLeft();
+    }
+    else if (m_cameraType == RIGHT_CAMERA)
+    {
+        viewOffset = m_device->viewMatrixRight();
+    }
+    else if (m_cameraType == COMBINED_CAMERA)
+    {
+        viewOffset = m_device->viewMatrixCombined();
+    }
 
-    viewOffset.preMultRotate(orientation);
-    viewOffset.setTrans(viewOffset.getTrans() + position);
-
-    slave._viewOffset = viewOffset;
+    slave._viewOffset = OpenVRDevice::headViewOffset(viewOffset, frame.position, frame.orientation);
 
     slave.updateSlaveImplementation(view);
 }
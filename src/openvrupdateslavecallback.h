@@ -18,7 +18,8 @@ struct OpenVRUpdateSlaveCallback : public osg::View::Slave::UpdateSlaveCallback
     enum CameraType
     {
         LEFT_CAMERA,
-        RIGHT_CAMERA
+        RIGHT_CAMERA,
+        COMBINED_CAMERA // apex of the combined frustum, used by the stereo cameras that draw both eyes
     };
 
     OpenVRUpdateSlaveCallback(CameraType cameraType, OpenVRDevice* device, OpenVRSwapCallback* swapCallback) :
@@ -7,6 +7,9 @@
 
 #include "openvrviewer.h"
 #include "openvrupdateslavecallback.h"
+#include "openvrstereorenderstage.h"
+
+#include <osgViewer/Renderer>
 
 /* Public functions */
 void OpenVRViewer::traverse(osg::NodeVisitor& nv)
@@ -17,6 +20,12 @@ void OpenVRViewer::traverse(osg::NodeVisitor& nv)
         configure();
     }
 
+    // The pose and resolution of a frame are fixed before the slave cameras are updated.
+    if (m_configured && nv.getVisitorType() == osg::NodeVisitor::UPDATE_VISITOR && nv.getFrameStamp() != nullptr)
+    {
+        m_device->beginFrame(nv.getFrameStamp()->getFrameNumber());
+    }
+
     osg::Group::traverse(nv);
 }
 
@@ -33,8 +42,35 @@ void OpenVRViewer::configure()
     camera->setName("Main");
     osg::Vec4 clearColor = camera->getClearColor();
 
-    // master projection matrix
-    camera->setProjectionMatrix(m_device->projectionMatrixCenter());
+    if (m_device->stereoMode() == OpenVRDevice::SINGLE_PASS)
+    {
+        // Culled once for both eyes, so the master projection has to cover both frustums.
+        camera->setProjectionMatrix(m_device->projectionMatrixCombined());
+        configureSinglePass(swapCallback.get(), clearColor, gc.get());
+    }
+    else if (m_device->stereoMode() == OpenVRDevice::SHARED_CULL)
+    {
+        camera->setProjectionMatrix(m_device->projectionMatrixCombined());
+        configureSharedCull(swapCallback.get(), clearColor, gc.get());
+    }
+    else
+    {
+        // master projection matrix
+        camera->setProjectionMatrix(m_device->projectionMatrixCenter());
+        configureMultiPass(swapCallback.get(), clearColor, gc.get());
+    }
+
+    // Use sky light instead of headlight to avoid light changes when head movements
+    m_view->setLightingMode(osg::View::SKY_LIGHT);
+
+    // Disable rendering of main camera since its being overwritten by the swap texture anyway
+    camera->setGraphicsContext(nullptr);
+
+    m_configured = true;
+}
+
+void OpenVRViewer::configureMultiPass(OpenVRSwapCallback* swapCallback, const osg::Vec4& clearColor, osg::GraphicsContext* gc)
+{
     // Create RTT cameras and attach textures
     m_cameraRTTLeft = m_device->createRTTCamera(OpenVRDevice::LEFT, osg::Camera::RELATIVE_RF, clearColor, gc);
     m_cameraRTTRight = m_device->createRTTCamera(OpenVRDevice::RIGHT, osg::Camera::RELATIVE_RF, clearColor, gc);
@@ -46,19 +82,45 @@ void OpenVRViewer::configure()
                      m_device->projectionOffsetMatrixLeft(),
                      m_device->viewMatrixLeft(),
                      true);
-    m_view->getSlave(0)._updateSlaveCallback = new OpenVRUpdateSlaveCallback(OpenVRUpdateSlaveCallback::LEFT_CAMERA, m_device.get(), swapCallback.get());
+    m_view->getSlave(0)._updateSlaveCallback = new OpenVRUpdateSlaveCallback(OpenVRUpdateSlaveCallback::LEFT_CAMERA, m_device.get(), swapCallback);
 
     m_view->addSlave(m_cameraRTTRight.get(),
                      m_device->projectionOffsetMatrixRight(),
                      m_device->viewMatrixRight(),
                      true);
-    m_view->getSlave(1)._updateSlaveCallback = new OpenVRUpdateSlaveCallback(OpenVRUpdateSlaveCallback::RIGHT_CAMERA, m_device.get(), swapCallback.get());
+    m_view->getSlave(1)._updateSlaveCallback = new OpenVRUpdateSlaveCallback(OpenVRUpdateSlaveCallback::RIGHT_CAMERA, m_device.get(), swapCallback);
+}
 
-    // Use sky light instead of headlight to avoid light changes when head movements
-    m_view->setLightingMode(osg::View::SKY_LIGHT);
+void OpenVRViewer::configureSinglePass(OpenVRSwapCallback* swapCallback, const osg::Vec4& clearColor, osg::GraphicsContext* gc)
+{
+    // One camera culls and draws the scene once, the stereo program renders both eyes.
+    m_cameraRTTStereo = m_device->createSinglePassStereoCamera(osg::Camera::RELATIVE_RF, clearColor, gc);
+    m_cameraRTTStereo->setName("StereoRTT");
 
-    // Disable rendering of main camera since its being overwritten by the swap texture anyway
-    camera->setGraphicsContext(nullptr);
+    m_view->addSlave(m_cameraRTTStereo.get(), osg::Matrix(), osg::Matrix(), true);
+    m_view->getSlave(0)._updateSlaveCallback = new OpenVRUpdateSlaveCallback(OpenVRUpdateSlaveCallback::COMBINED_CAMERA, m_device.get(), swapCallback);
+}
 
-    m_configured = true;
+void OpenVRViewer::configureSharedCull(OpenVRSwapCallback* swapCallback, const osg::Vec4& clearColor, osg::GraphicsContext* gc)
+{
+    // One camera culls the scene with the combined frustum, its render stage draws the result for each eye.
+    m_cameraRTTStereo = m_device->createSharedCullCamera(osg::Camera::RELATIVE_RF, clearColor, gc);
+    m_cameraRTTStereo->setName("SharedCullRTT");
+    m_cameraRTTStereo->setCullCallback(new OpenVRStereoCullCallback());
+
+    m_view->addSlave(m_cameraRTTStereo.get(), osg::Matrix(), osg::Matrix(), true);
+    m_view->getSlave(0)._updateSlaveCallback = new OpenVRUpdateSlaveCallback(OpenVRUpdateSlaveCallback::COMBINED_CAMERA, m_device.get(), swapCallback);
+
+    osgViewer::Renderer* renderer = dynamic_cast<osgViewer::Renderer*>(m_cameraRTTStereo->getRenderer());
+    if (renderer == nullptr)
+    {
+        osg::notify(osg::WARN) << "Error: Shared cull camera has no renderer, eyes will not be drawn." << std::endl;
+        return;
+    }
+
+    // Both scene views are used alternately when cull and draw run in parallel.
+    for (unsigned int i = 0; i < 2; ++i)
+    {
+        renderer->getSceneView(i)->setRenderStage(new OpenVRStereoRenderStage(m_device.get()));
+    }
 }
@@ -25,7 +25,7 @@ public:
     OpenVRViewer(osgViewer::View* view, osg::ref_ptr<OpenVRDevice> dev, osg::ref_ptr<OpenVRRealizeOperation> realizeOperation) : osg::Group(),
         m_configured(false),
         m_view(view),
-        m_cameraRTTLeft(nullptr), m_cameraRTTRight(nullptr),
+        m_cameraRTTLeft(nullptr), m_cameraRTTRight(nullptr), m_cameraRTTStereo(nullptr),
         m_device(dev),
         m_realizeOperation(realizeOperation)
     {};
@@ -33,11 +33,14 @@ public:
 protected:
     ~OpenVRViewer() {};
     virtual void configure();
+    void configureMultiPass(OpenVRSwapCallback* swapCallback, const osg::Vec4& clearColor, osg::GraphicsContext* gc);
+    void configureSinglePass(OpenVRSwapCallback* swapCallback, const osg::Vec4& clearColor, osg::GraphicsContext* gc);
+    void configureSharedCull(OpenVRSwapCallback* swapCallback, const osg::Vec4& clearColor, osg::GraphicsContext* gc);
 
     bool m_configured;
 
     osg::observer_ptr<osgViewer::View> m_view;
-    osg::observer_ptr<osg::Camera> m_cameraRTTLeft, m_cameraRTTRight;
+    osg::observer_ptr<osg::Camera> m_cameraRTTLeft, m_cameraRTTRight, m_cameraRTTStereo;
     osg::observer_ptr<OpenVRDevice> m_device;
     osg::observer_ptr<OpenVRRealizeOperation> m_realizeOperation;
 };
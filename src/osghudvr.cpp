@@ -1,197 +1,234 @@
+/*
+ * osghudvr.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
 #include "osghudvr.h"
 #include "openvrdevice.h"
-#include <osgText/Text>
-#include <osg/PolygonOffset>
+#include "openvrhudtext.h"
+#include "openvrsinglepassstate.h"
+
+#include <osg/BlendFunc>
+#include <osg/Geometry>
+#include <osg/Math>
+#include <osg/Program>
+#include <OpenThreads/ScopedLock>
+
+#ifndef GL_CLIP_DISTANCE0
+    #define GL_CLIP_DISTANCE0 0x3000
+    #define GL_CLIP_DISTANCE1 0x3001
+#endif
+
+// Smallest and largest layer edge in pixels.
+static const int s_minLayerSize = 64;
+static const int s_maxLayerSize = 4096;
+
+// Only lets the cull visitor reach the layer camera while the layer is dirty.
+class OSGHudVRLayerCullCallback : public osg::NodeCallback
+{
+public:
+    explicit OSGHudVRLayerCullCallback(OSGHudVR* hud) : m_hud(hud) {}
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        if (m_hud->renderLayer())
+        {
+            traverse(node, nv);
+        }
+    }
 
-OSGHudVR::OSGHudVR()
+protected:
+    OSGHudVR* m_hud; // owns the node this callback is set on
+};
+
+OSGHudVR::OSGHudVR(OpenVRDevice* device, osg::Camera* camera, float width, float distance) :
+    osg::Transform(),
+    m_device(device),
+    m_camera(camera),
+    m_layerWidth(s_minLayerSize),
+    m_layerHeight(s_minLayerSize),
+    m_dirty(true)
 {
-    createHud();
+    // Fraction of the eye's width the panel covers, the layer gets the same share of the eye
+    // buffer's pixels and the panel the same share of the eye's height.
+    uint32_t eyeWidth = 0;
+    uint32_t eyeHeight = 0;
+    device->backend()->recommendedRenderTargetSize(eyeWidth, eyeHeight);
+    // Taken from the backend, so it does not matter whether the device has computed its projections
+    // yet. The scale terms do not depend on the clip planes.
+    const vr::HmdMatrix44_t projection = device->backend()->projectionMatrix(vr::Eye_Left, 0.1f, 1.0f);
+    const double coverage = projection.m[0][0] * width / (2.0 * distance);
+    const float height = static_cast<float>(2.0 * distance * coverage / projection.m[1][1]);
+    m_layerWidth = osg::clampBetween(static_cast<int>(eyeWidth * coverage), s_minLayerSize, s_maxLayerSize);
+    m_layerHeight = osg::clampBetween(static_cast<int>(eyeHeight * coverage), s_minLayerSize, s_maxLayerSize);
+
+    m_layerTexture = new osg::Texture2D;
+    m_layerTexture->setTextureSize(m_layerWidth, m_layerHeight);
+    m_layerTexture->setInternalFormat(GL_RGBA8);
+    m_layerTexture->setFilter(osg::Texture::MIN_FILTER, osg::Texture::LINEAR);
+    m_layerTexture->setFilter(osg::Texture::MAG_FILTER, osg::Texture::LINEAR);
+    m_layerTexture->setWrap(osg::Texture::WRAP_S, osg::Texture::CLAMP_TO_EDGE);
+    m_layerTexture->setWrap(osg::Texture::WRAP_T, osg::Texture::CLAMP_TO_EDGE);
+
+    m_content = new osg::Group;
+
+    m_layerCamera = new osg::Camera;
+    m_layerCamera->setClearColor(osg::Vec4(0.0f, 0.0f, 0.0f, 0.0f));
+    m_layerCamera->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    m_layerCamera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
+    m_layerCamera->setRenderOrder(osg::Camera::PRE_RENDER);
+    m_layerCamera->setReferenceFrame(osg::Camera::ABSOLUTE_RF);
+    m_layerCamera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
+    m_layerCamera->setAllowEventFocus(false);
+    m_layerCamera->setViewport(0, 0, m_layerWidth, m_layerHeight);
+    m_layerCamera->setProjectionMatrixAsOrtho2D(0, m_layerWidth, 0, m_layerHeight);
+    m_layerCamera->setViewMatrix(osg::Matrix::identity());
+    m_layerCamera->attach(osg::Camera::COLOR_BUFFER, m_layerTexture.get());
+    m_layerCamera->addChild(m_content.get());
+
+    // The layer holds premultiplied colors, so it blends the same as the content would have.
+    osg::StateSet* layerState = m_layerCamera->getOrCreateStateSet();
+    layerState->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    layerState->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+    layerState->setAttributeAndModes(new osg::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA),
+                                     osg::StateAttribute::ON | osg::StateAttribute::OVERRIDE);
+    // The layer camera is nested in the eye camera, but draws a flat image of its own. The
+    // single pass stereo program and clip planes the eye camera overrides must not reach it.
+    layerState->setAttributeAndModes(new osg::Program, osg::StateAttribute::ON | osg::StateAttribute::PROTECTED);
+    layerState->setMode(GL_CLIP_DISTANCE0, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+    layerState->setMode(GL_CLIP_DISTANCE1, osg::StateAttribute::OFF | osg::StateAttribute::PROTECTED);
+
+    osg::ref_ptr<osg::Group> layer = new osg::Group;
+    layer->setCullingActive(false);
+    layer->setCullCallback(new OSGHudVRLayerCullCallback(this));
+    layer->addChild(m_layerCamera.get());
+    addChild(layer.get());
+
+    // The panel, in metres in head space.
+    osg::ref_ptr<osg::Geometry> panel = osg::createTexturedQuadGeometry(
+        osg::Vec3(-0.5f * width, -0.5f * height, -distance), osg::Vec3(width, 0.0f, 0.0f), osg::Vec3(0.0f, height, 0.0f));
+    panel->setUseDisplayList(false);
+    panel->setUseVertexBufferObjects(true);
+
+    osg::ref_ptr<osg::Geode> panelGeode = new osg::Geode;
+    panelGeode->addDrawable(panel.get());
+    osg::StateSet* panelState = panelGeode->getOrCreateStateSet();
+    panelState->setTextureAttributeAndModes(0, m_layerTexture.get(), osg::StateAttribute::ON);
+    panelState->setAttributeAndModes(new osg::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA), osg::StateAttribute::ON);
+    panelState->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+    OpenVRSinglePassStateVisitor::applyStateSet(panelState);
+    panelState->setMode(GL_DEPTH_TEST, osg::StateAttribute::OFF);
+    // Drawn over the scene.
+    panelState->setRenderBinDetails(1000, "RenderBin");
+    addChild(panelGeode.get());
+
+    // The bound moves with the head, which the cull visitor does not know about.
+    setCullingActive(false);
 }
 
-osg::Camera *OSGHudVR::createHudLeft(osg::GraphicsContext *gc, OpenVRDevice *device, osg::Vec4 clearColor)
+void OSGHudVR::setDirty()
 {
-    OpenVRTextureBuffer* buffer = device->getTextureBufferLeft();
-
-    osg::ref_ptr<osg::Camera> camera = new osg::Camera();
-    camera->setClearColor(clearColor);
-    camera->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
-    camera->setRenderOrder(osg::Camera::PRE_RENDER, OpenVRDevice::LEFT);
-    camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
-    camera->setAllowEventFocus(false);
-    camera->setReferenceFrame(osg::Camera::ABSOLUTE_RF_INHERIT_VIEWPOINT);
-    camera->setViewport(0, 0, buffer->textureWidth(), buffer->textureHeight());
-    camera->setGraphicsContext(gc);
-
-    // Here we avoid doing anything regarding OSG camera RTT attachment.
-    // Ideally we would use automatic methods within OSG for handling RTT but in this
-    // case it seemed simpler to handle FBO creation and selection within this class.
-
-    // This initial draw callback is used to disable normal OSG camera setup which
-    // would undo our RTT FBO configuration.
-    camera->setInitialDrawCallback(new OpenVRInitialDrawCallback());
-
-    camera->setPreDrawCallback(new OpenVRPreDrawCallback(camera.get(), buffer));
-    camera->setFinalDrawCallback(new OpenVRPostDrawCallback(camera.get(), buffer));
-    camera->setRenderOrder(osg::Camera::POST_RENDER, OpenVRDevice::LEFT);
-    // only clear the depth buffer !!!
-    camera->setClearMask(GL_DEPTH_BUFFER_BIT);
-    camera->setProjectionMatrix(osg::Matrix::ortho2D(0,1080,0,1200) * device->projectionOffsetMatrixLeft());
-    return camera.release();
-
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    m_dirty = true;
 }
 
-osg::Camera *OSGHudVR::createHudRight(osg::GraphicsContext *gc, OpenVRDevice *device, osg::Vec4 clearColor)
+bool OSGHudVR::renderLayer()
 {
-    OpenVRTextureBuffer* buffer = device->getTextureBufferRight();
-
-    osg::ref_ptr<osg::Camera> camera = new osg::Camera();
-    camera->setClearColor(clearColor);
-    camera->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    camera->setRenderTargetImplementation(osg::Camera::FRAME_BUFFER_OBJECT);
-    camera->setRenderOrder(osg::Camera::PRE_RENDER, OpenVRDevice::RIGHT);
-    camera->setComputeNearFarMode(osg::CullSettings::DO_NOT_COMPUTE_NEAR_FAR);
-    camera->setAllowEventFocus(false);
-    camera->setReferenceFrame(osg::Camera::ABSOLUTE_RF_INHERIT_VIEWPOINT);
-    camera->setViewport(0, 0, buffer->textureWidth(), buffer->textureHeight());
-    camera->setGraphicsContext(gc);
-
-    // Here we avoid doing anything regarding OSG camera RTT attachment.
-    // Ideally we would use automatic methods within OSG for handling RTT but in this
-    // case it seemed simpler to handle FBO creation and selection within this class.
-
-    // This initial draw callback is used to disable normal OSG camera setup which
-    // would undo our RTT FBO configuration.
-    camera->setInitialDrawCallback(new OpenVRInitialDrawCallback());
-
-    camera->setPreDrawCallback(new OpenVRPreDrawCallback(camera.get(), buffer));
-    camera->setFinalDrawCallback(new OpenVRPostDrawCallback(camera.get(), buffer));
-    camera->setRenderOrder(osg::Camera::POST_RENDER, OpenVRDevice::RIGHT);
-    // only clear the depth buffer !!!
-    camera->setClearMask(GL_DEPTH_BUFFER_BIT);
-    camera->setProjectionMatrix(osg::Matrix::ortho2D(0,1080,0,1200) * device->projectionOffsetMatrixRight());
-    return camera.release();
-
+    OpenThreads::ScopedLock<OpenThreads::Mutex> lock(m_mutex);
+    const bool dirty = m_dirty;
+    m_dirty = false;
+    return dirty;
 }
 
-osg::Geode* OSGHudVR::createHud()
+bool OSGHudVR::computeLocalToWorldMatrix(osg::Matrix& matrix, osg::NodeVisitor*) const
 {
-    osg::ref_ptr<osg::Geode> geode = new osg::Geode();
-
-    std::string timesFont("fonts/arial.ttf");
-
-    // turn lighting off for the text and disable depth test to ensure it's always ontop.
-    osg::StateSet* stateset = geode->getOrCreateStateSet();
-    stateset->setMode(GL_LIGHTING,osg::StateAttribute::OFF);
-
-    osg::Vec3 position(150.0f,800.0f,-0.5f);
-    osg::Vec3 delta(0.0f,-120.0f,0.0f);
-
+    if (_referenceFrame == RELATIVE_RF)
     {
-        osgText::Text* text = new  osgText::Text;
-        geode->addDrawable( text );
-
-        text->setFont(timesFont);
-        text->setPosition(position);
-        text->setText("Head Up Displays are simple :-)");
-
-        position += delta;
+        matrix.preMult(headToWorld());
     }
-
-
+    else
     {
-        osgText::Text* text = new  osgText::Text;
-        geode->addDrawable( text );
-
-        text->setFont(timesFont);
-        text->setPosition(position);
-        text->setText("All you need to do is create your text in a subgraph.");
-
-        position += delta;
+        matrix = headToWorld();
     }
+    return true;
+}
 
-
+bool OSGHudVR::computeWorldToLocalMatrix(osg::Matrix& matrix, osg::NodeVisitor*) const
+{
+    const osg::Matrix worldToHead = osg::Matrix::inverse(headToWorld());
+    if (_referenceFrame == RELATIVE_RF)
     {
-        osgText::Text* text = new  osgText::Text;
-        geode->addDrawable( text );
-
-        text->setFont(timesFont);
-        text->setPosition(position);
-        text->setText("Then place an osg::Camera above the subgraph\n"
-                      "to create an orthographic projection.\n");
-
-        position += delta;
+        matrix.postMult(worldToHead);
     }
-
+    else
     {
-        osgText::Text* text = new  osgText::Text;
-        geode->addDrawable( text );
-
-        text->setFont(timesFont);
-        text->setPosition(position);
-        text->setText("Set the Camera's ReferenceFrame to ABSOLUTE_RF to ensure\n"
-                      "it remains independent from any external model view matrices.");
-
-        position += delta;
+        matrix = worldToHead;
     }
+    return true;
+}
 
-    {
-        osgText::Text* text = new  osgText::Text;
-        geode->addDrawable( text );
-
-        text->setFont(timesFont);
-        text->setPosition(position);
-        text->setText("And set the Camera's clear mask to just clear the depth buffer.");
+osg::Geode* OSGHudVR::createHud(int width, int height)
+{
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode();
 
-        position += delta;
-    }
+    const float characterSize = height / 14.0f;
+    osg::Vec2 position(width * 0.08f, height * 0.82f);
+    osg::Vec2 delta(0.0f, -characterSize * 1.6f);
 
+    const char* lines[] =
     {
-        osgText::Text* text = new  osgText::Text;
-        geode->addDrawable( text );
-
-        text->setFont(timesFont);
-        text->setPosition(position);
-        text->setText("And finally set the Camera's RenderOrder to POST_RENDER\n"
-                      "to make sure it's drawn last.");
-
+        "Head Up Displays are simple :-)",
+        "The text is drawn into a layer texture",
+        "only when it changes.",
+        "Each eye then draws the layer",
+        "as a single textured quad.",
+        "Call setDirty() to update it."
+    };
+    // All lines are labels of one drawable.
+    osg::ref_ptr<OpenVRHudText> text = new OpenVRHudText("fonts/arial.ttf", characterSize);
+    for (const char* line : lines)
+    {
+        text->addLabel(position, line);
         position += delta;
     }
-
+    geode->addDrawable(text.get());
 
     {
-        osg::BoundingBox bb;
-        for(unsigned int i=0;i<geode->getNumDrawables();++i)
-        {
-            bb.expandBy(geode->getDrawable(i)->getBoundingBox());
-        }
-
-        osg::Geometry* geom = new osg::Geometry;
-
-        osg::Vec3Array* vertices = new osg::Vec3Array;
-        float depth = bb.zMin()-0.1;
-        vertices->push_back(osg::Vec3(bb.xMin(),bb.yMax(),depth));
-        vertices->push_back(osg::Vec3(bb.xMin(),bb.yMin(),depth));
-        vertices->push_back(osg::Vec3(bb.xMax(),bb.yMin(),depth));
-        vertices->push_back(osg::Vec3(bb.xMax(),bb.yMax(),depth));
-        geom->setVertexArray(vertices);
+        const osg::BoundingBox& bb = text->getBoundingBox();
+        const float margin = characterSize * 0.5f;
 
-        osg::Vec3Array* normals = new osg::Vec3Array;
-        normals->push_back(osg::Vec3(0.0f,0.0f,1.0f));
-        geom->setNormalArray(normals, osg::Array::BIND_OVERALL);
+        osg::Geometry* geom = osg::createTexturedQuadGeometry(
+            osg::Vec3(bb.xMin() - margin, bb.yMin() - margin, 0.0f),
+            osg::Vec3(bb.xMax() - bb.xMin() + 2.0f * margin, 0.0f, 0.0f),
+            osg::Vec3(0.0f, bb.yMax() - bb.yMin() + 2.0f * margin, 0.0f));
 
         osg::Vec4Array* colors = new osg::Vec4Array;
-        colors->push_back(osg::Vec4(1.0f,1.0,0.8f,0.2f));
+        colors->push_back(osg::Vec4(1.0f, 1.0f, 0.8f, 0.2f));
         geom->setColorArray(colors, osg::Array::BIND_OVERALL);
 
-        geom->addPrimitiveSet(new osg::DrawArrays(GL_QUADS,0,4));
-
+        // Without depth test the background has to be drawn before the text.
         osg::StateSet* stateset = geom->getOrCreateStateSet();
-        stateset->setMode(GL_BLEND,osg::StateAttribute::ON);
-        stateset->setAttribute(new osg::PolygonOffset(1.0f,1.0f),osg::StateAttribute::ON);
-        stateset->setRenderingHint(osg::StateSet::TRANSPARENT_BIN);
+        stateset->setMode(GL_BLEND, osg::StateAttribute::ON);
+        stateset->setRenderBinDetails(-1, "RenderBin");
 
         geode->addDrawable(geom);
     }
     return geode.release();
 }
+
+/* Protected functions */
+osg::Matrix OSGHudVR::headToWorld() const
+{
+    // The eye cameras see the head pose of the frame, in world units, through the view of this camera.
+    osg::ref_ptr<osg::Camera> camera;
+    osg::ref_ptr<OpenVRDevice> device;
+    if (!m_camera.lock(camera) || !m_device.lock(device))
+    {
+        return osg::Matrix::identity();
+    }
+    const OpenVRFrameState& frame = device->frameState();
+    const osg::Matrix headView = osg::Matrix::rotate(frame.orientation) * osg::Matrix::translate(frame.position);
+    const float scale = device->worldUnitsPerMetre();
+    return osg::Matrix::scale(scale, scale, scale) * osg::Matrix::inverse(headView) * camera->getInverseViewMatrix();
+}
@@ -1,17 +1,66 @@
-#ifndef OSGHUDVR_H
-#define OSGHUDVR_H
+/*
+ * osghudvr.h
+ *
+ *  Created on: Oct 16, 2026
+ */
 
+#ifndef _OSG_OSGHUDVR_H_
+#define _OSG_OSGHUDVR_H_
+
+#include <osg/Transform>
 #include <osg/Camera>
+#include <osg/Geode>
+#include <osg/Texture2D>
+#include <osg/observer_ptr>
+#include <OpenThreads/Mutex>
 
+// Forward declaration
 class OpenVRDevice;
 
-class OSGHudVR
+// Head locked HUD. The content is rendered into a layer texture by a camera that is only
+// culled in a frame after setDirty() was called, every eye then draws the layer as one
+// textured quad, so static text costs a single quad per eye. The quad is a panel in front
+// of the head, the layer resolution matches the texel density of the eye buffers there.
+class OSGHudVR : public osg::Transform
 {
 public:
-    OSGHudVR();
-    static osg::Camera *createHudLeft(osg::GraphicsContext *gc, OpenVRDevice *device, osg::Vec4 clearColor);
-    static osg::Camera *createHudRight(osg::GraphicsContext *gc, OpenVRDevice *device, osg::Vec4 clearColor);
-    static osg::Geode* createHud();
+    // width and distance of the panel in metres, the height follows from the eye's aspect ratio.
+    OSGHudVR(OpenVRDevice* device, osg::Camera* camera, float width = 1.0f, float distance = 1.5f);
+
+    // Subgraph rendered into the layer, in pixels of the layer texture with the origin at the
+    // bottom left. Call setDirty() after changing it.
+    osg::Group* content() const { return m_content.get(); }
+    int layerWidth() const { return m_layerWidth; }
+    int layerHeight() const { return m_layerHeight; }
+
+    // The layer is rendered again in the next frame. Can be called from any thread.
+    void setDirty();
+
+    virtual bool computeLocalToWorldMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const;
+    virtual bool computeWorldToLocalMatrix(osg::Matrix& matrix, osg::NodeVisitor* nv) const;
+
+    // Called by the cull callback above the layer camera, true for the first eye culled after setDirty().
+    bool renderLayer();
+
+    // Example content for a layer of the given size.
+    static osg::Geode* createHud(int width, int height);
+
+protected:
+    ~OSGHudVR() {}
+
+    osg::Matrix headToWorld() const;
+
+    osg::observer_ptr<OpenVRDevice> m_device;
+    osg::observer_ptr<osg::Camera> m_camera;
+
+    int m_layerWidth;
+    int m_layerHeight;
+    osg::ref_ptr<osg::Texture2D> m_layerTexture;
+    osg::ref_ptr<osg::Camera> m_layerCamera;
+    osg::ref_ptr<osg::Group> m_content;
+
+    OpenThreads::Mutex m_mutex; // guards m_dirty, eyes may be culled in parallel
+    bool m_dirty;
 };
 
-#endif // OSGHUDVR_H
+#endif /* _OSG_OSGHUDVR_H_ */
@@ -0,0 +1,154 @@
+/*
+ * posebenchmark.cpp
+ *
+ *  Created on: Oct 16, 2026
+ */
+
+#include <osg/ArgumentParser>
+#include <osg/Matrix>
+#include <osg/Timer>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include "openvrposeconversion.h"
+
+// The conversion OpenVRDevice used before OpenVRPoseConversion: a general matrix
+// inverse and decomposition per device.
+static void convertMatrixPath(const vr::TrackedDevicePose_t* poses, unsigned int count, OpenVRRigidPose* result)
+{
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        const vr::HmdMatrix34_t& mat34 = poses[i].mDeviceToAbsoluteTracking;
+        const osg::Matrix matrix(
+            mat34.m[0][0], mat34.m[1][0], mat34.m[2][0], 0.0,
+            mat34.m[0][1], mat34.m[1][1], mat34.m[2][1], 0.0,
+            mat34.m[0][2], mat34.m[1][2], mat34.m[2][2], 0.0,
+            mat34.m[0][3], mat34.m[1][3], mat34.m[2][3], 1.0f
+            );
+        const osg::Matrix inverse = osg::Matrix::inverse(matrix);
+        result[i].position = matrix.getTrans();
+        result[i].orientation = matrix.getRotate();
+        result[i].inversePosition = inverse.getTrans();
+        result[i].inverseOrientation = inverse.getRotate();
+        result[i].valid = poses[i].bPoseIsValid;
+    }
+}
+
+// Random rotations and translations within a room. The first poses are half turns,
+// which have w = 0 and are the hardest case for extracting the quaternion.
+static void createPoses(std::vector<vr::TrackedDevicePose_t>& poses)
+{
+    const osg::Vec3d halfTurnAxes[] = { osg::Vec3d(1.0, -1.0, 0.0), osg::Vec3d(1.0, 0.0, 0.0), osg::Vec3d(0.0, 1.0, 0.0),
+                                        osg::Vec3d(0.0, 0.0, 1.0), osg::Vec3d(-1.0, 2.0, -3.0) };
+    const size_t halfTurns = sizeof(halfTurnAxes) / sizeof(halfTurnAxes[0]);
+
+    for (size_t i = 0; i < poses.size(); ++i)
+    {
+        vr::TrackedDevicePose_t& pose = poses[i];
+        osg::Vec3d axis(std::rand() - RAND_MAX / 2, std::rand() - RAND_MAX / 2, std::rand() - RAND_MAX / 2);
+        double angle = 2.0 * osg::PI * std::rand() / RAND_MAX;
+        if (i < halfTurns)
+        {
+            axis = halfTurnAxes[i];
+            angle = osg::PI;
+        }
+        axis.normalize();
+        const osg::Matrix rotation = osg::Matrix::rotate(angle, axis);
+        for (int row = 0; row < 3; ++row)
+        {
+            for (int column = 0; column < 3; ++column)
+            {
+                // OpenVR matrices are row major for column vectors, the transpose of OSG's
+                pose.mDeviceToAbsoluteTracking.m[row][column] = static_cast<float>(rotation(column, row));
+            }
+            pose.mDeviceToAbsoluteTracking.m[row][3] = 4.0f * std::rand() / RAND_MAX - 2.0f;
+        }
+        pose.bPoseIsValid = true;
+        pose.bDeviceIsConnected = true;
+        pose.eTrackingResult = vr::TrackingResult_Running_OK;
+    }
+}
+
+// Largest difference of the positions and quaternions, with q and -q being the same rotation.
+static float maxDifference(const std::vector<OpenVRRigidPose>& a, const std::vector<OpenVRRigidPose>& b)
+{
+    float difference = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i)
+    {
+        const float sign = (a[i].orientation.asVec4() * b[i].orientation.asVec4() < 0.0) ? -1.0f : 1.0f;
+        for (int j = 0; j < 4; ++j)
+        {
+            difference = std::max(difference, static_cast<float>(std::fabs(a[i].orientation[j] - sign * b[i].orientation[j])));
+            difference = std::max(difference, static_cast<float>(std::fabs(a[i].inverseOrientation[j] - sign * b[i].inverseOrientation[j])));
+        }
+        difference = std::max(difference, (a[i].position - b[i].position).length());
+        difference = std::max(difference, (a[i].inversePosition - b[i].inversePosition).length());
+    }
+    return difference;
+}
+
+typedef void (*ConvertFunction)(const vr::TrackedDevicePose_t*, unsigned int, OpenVRRigidPose*);
+
+// Nanoseconds per device, the best of several runs.
+static double measure(ConvertFunction convert, const std::vector<vr::TrackedDevicePose_t>& poses, std::vector<OpenVRRigidPose>& result, unsigned int iterations)
+{
+    const unsigned int runs = 5;
+    double best = 0.0;
+    for (unsigned int run = 0; run < runs; ++run)
+    {
+        const osg::Timer_t start = osg::Timer::instance()->tick();
+        for (unsigned int i = 0; i < iterations; ++i)
+        {
+            convert(&poses[0], static_cast<unsigned int>(poses.size()), &result[0]);
+        }
+        const double ns = osg::Timer::instance()->delta_n(start, osg::Timer::instance()->tick()) / (static_cast<double>(iterations) * poses.size());
+        if (run == 0 || ns < best)
+        {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+int main(int argc, char** argv)
+{
+    osg::ArgumentParser arguments(&argc, argv);
+    unsigned int iterations = 100000;
+    arguments.read("--iterations", iterations);
+    // The matrix path converts in double precision, the rigid paths in single precision.
+    float tolerance = 1.0e-4f;
+    arguments.read("--tolerance", tolerance);
+    bool failed = false;
+
+    std::cout << "Pose conversion, " << OpenVRPoseConversion::instructionSet() << " build, " << iterations << " iterations" << std::endl;
+
+    const unsigned int deviceCounts[] = { 1, vr::k_unMaxTrackedDeviceCount };
+    for (unsigned int devices : deviceCounts)
+    {
+        std::vector<vr::TrackedDevicePose_t> poses(devices);
+        createPoses(poses);
+
+        std::vector<OpenVRRigidPose> matrixResult(devices), scalarResult(devices), batchedResult(devices);
+        const double matrixNs = measure(convertMatrixPath, poses, matrixResult, iterations);
+        const double scalarNs = measure(OpenVRPoseConversion::convertScalar, poses, scalarResult, iterations);
+        const double batchedNs = measure(OpenVRPoseConversion::convert, poses, batchedResult, iterations);
+
+        std::cout << devices << " device(s), ns per device:" << std::endl;
+        std::cout << "  matrix inverse " << matrixNs << std::endl;
+        std::cout << "  rigid scalar   " << scalarNs << " (" << matrixNs / scalarNs << "x)" << std::endl;
+        std::cout << "  rigid batched  " << batchedNs << " (" << matrixNs / batchedNs << "x)" << std::endl;
+
+        const float difference = std::max(maxDifference(matrixResult, scalarResult), maxDifference(matrixResult, batchedResult));
+        std::cout << "  max difference to matrix inverse " << difference << std::endl;
+        if (difference > tolerance)
+        {
+            std::cout << "Error: difference exceeds the tolerance of " << tolerance << std::endl;
+            failed = true;
+        }
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
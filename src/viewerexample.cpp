@@ -5,131 +5,46 @@
  *      Author: Chris Denham
  */
 
+#include <osg/AnimationPath>
+#include <osg/PositionAttitudeTransform>
+#include <osg/ShapeDrawable>
+#include <osg/PolygonMode>
 #include <osgDB/ReadFile>
 #include <osgGA/TrackballManipulator>
 #include <osgViewer/Viewer>
+#include <OpenThreads/Thread>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+#include <vector>
 
 #include "openvrviewer.h"
 #include "openvreventhandler.h"
+#include "openvrsimulatedbackend.h"
+#include "openvrmanipulator.h"
+#include "openvrcontrollermodels.h"
+#include "osghudvr.h"
+#include "openvrhudtext.h"
+#include "openvrsceneloader.h"
+#include "openvrstartuptimeline.h"
+#include "openvrscenecache.h"
 
 class GraphicsWindowViewer : public osgViewer::Viewer
 {
 public:
 
-    GraphicsWindowViewer(osg::ref_ptr<OpenVRDevice> openvr,osg::ArgumentParser& arguments, osgViewer::GraphicsWindow* graphicsWindow)
+    GraphicsWindowViewer(osg::ArgumentParser& arguments, osgViewer::GraphicsWindow* graphicsWindow)
         : osgViewer::Viewer(arguments), _graphicsWindow(graphicsWindow)
     {
-		openvrDevice = openvr;
-		fake_position_x = 0;
-		fake_position_y = 0;
-		trigger = false;
+    }
+
+    void setGraphicsWindow(osgViewer::GraphicsWindow* graphicsWindow)
+    {
+        _graphicsWindow = graphicsWindow;
     }
 
     virtual void eventTraversal()
     {
-		// 添加VR事件响应，映射成鼠标事件
-		// 按下trigger时，进行旋转
-		// 按下trackpad时，进行缩放
-		if (openvrDevice->controllerEventResult != -1)
-		{
-			osg::ref_ptr<osgGA::GUIEventAdapter> controllerBeforeEvent = new osgGA::GUIEventAdapter;
-			osg::ref_ptr<osgGA::GUIEventAdapter> controllerEvent = new osgGA::GUIEventAdapter;
-			osg::ref_ptr<osgGA::GUIEventAdapter> controllerAfterEvent = new osgGA::GUIEventAdapter;
-
-			controllerBeforeEvent->setEventType(osgGA::GUIEventAdapter::PUSH);
-			controllerAfterEvent->setEventType(osgGA::GUIEventAdapter::RELEASE);
-
-			switch (openvrDevice->controllerEventResult)
-			{
-
-			// Touchpad 按下
-			case OpenVRDevice::Touchpad_Press:
-			{
-				double angle = VectorAngle(openvrDevice->m_touchpadTouchPosition);
-				
-				TouchpadLocation location = GetTouchpadLocation(angle);
-				controllerEvent->setEventType(osgGA::GUIEventAdapter::DRAG);
-
-				if(location == UP)
-				{
-					if(trigger)
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON);
-					else
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON);
-					
-					controllerEvent->setY(fake_position_y);
-				}
-				else if (location == DOWN)
-				{
-					if (trigger)
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON);
-					else
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON);
-					controllerEvent->setY(-fake_position_y);
-				}
-				else if (location == LEFT)
-				{
-					if (trigger)
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON);
-					else
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON);
-					controllerEvent->setX(-fake_position_x);
-
-				}
-				else if (location == RIGHT)
-				{
-					if (trigger)
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::MIDDLE_MOUSE_BUTTON);
-					else
-						controllerEvent->setButtonMask(osgGA::GUIEventAdapter::RIGHT_MOUSE_BUTTON);
-					controllerEvent->setX(fake_position_x);
-				}
-
-				
-				fake_position_x += 1;
-				fake_position_y += 1;
-			}
-			break;
-			// 按键弹起后，首先释放release消息
-			// 然后复位所有信息
-			case OpenVRDevice::Touchpad_Unpress:
-			{
-				controllerEvent->setEventType(osgGA::GUIEventAdapter::RELEASE);
-				controllerEvent->setButtonMask(0);
-				controllerEvent->setX(fake_position_x);
-				controllerEvent->setY(fake_position_y);
-				fake_position_x = 0;
-				fake_position_y = 0;
-				openvrDevice->controllerEventResult = -1;
-			}
-			break;
-			case OpenVRDevice::Trigger_Press:
-			{
-				if (trigger == false)
-					trigger = true;
-			}
-			case OpenVRDevice::Trigger_Unpress:
-			{
-				trigger = false;
-				controllerEvent->setEventType(osgGA::GUIEventAdapter::RELEASE);
-				controllerEvent->setButtonMask(0);
-				controllerEvent->setX(fake_position_x);
-				controllerEvent->setY(fake_position_y);
-				fake_position_x = 0;
-				fake_position_y = 0;
-				openvrDevice->controllerEventResult = -1;
-			}
-			break;
-			default:
-			{
-				controllerEvent->setEventType(osgGA::GUIEventAdapter::RELEASE);
-				printf("release actiated!");
-				controllerEvent->setButtonMask(0);
-			}
-			}
-			_graphicsWindow->getEventQueue()->addEvent(controllerEvent);
-		}
-		
         if (_graphicsWindow.valid() && _graphicsWindow->checkEvents())
         {
 
@@ -164,103 +79,240 @@ public:
     }
 private:
     osg::ref_ptr<osgViewer::GraphicsWindow> _graphicsWindow;
-	osg::ref_ptr<OpenVRDevice> openvrDevice;
-
-	double fake_position_x;
-	double fake_position_y;
-	bool trigger;
-	typedef enum TouchpadLocation_
-	{
-		UP,
-		DOWN,
-		LEFT,
-		RIGHT
-	} TouchpadLocation;
-
-	double VectorAngle(osg::Vec2f &v2)
-	{
-		osg::Vec2f v1(1, 0);
-		double up = v1*v2;
-		double down = v1.length() * v2.length();
-		double cosr = up / down;
-		double angle = acos(cosr) * 180 / osg::PI;
-		if (v2.x() < 0 && v2.y() < 0)
-		{
-			angle = -angle;
-		}
-		else if (v2.x() > 0 && v2.y() < 0)
-		{
-			angle = -angle;
-		}
-		return angle;
-	}
-	TouchpadLocation GetTouchpadLocation(double angle)
-	{
-		if (angle > 45 && angle < 135)
-		{
-			printf("down");
-			return DOWN;
-
-		}
-		//上  
-		if (angle < -45 && angle > -135)
-		{
-			printf("up");
-			return UP;
-
-		}
-		//左  
-		if ((angle < 180 && angle > 135) || (angle < -135 && angle > -180))
-		{
-			printf("left");
-			return LEFT;
-		}
-		//右  
-		if ((angle > 0 && angle < 45) || (angle > -45 && angle < 0))
-		{
-			controllerEvent->setX(-fake_position_x);
-			return RIGHT;
-		}
-	}
+};
 
+// Shows the latest position of every tracked device slot as a label on the HUD.
+class HudReadoutCallback : public osg::NodeCallback
+{
+public:
+    HudReadoutCallback(OpenVRDevice* device, OSGHudVR* hud, OpenVRHudText* text) : m_device(device), m_hud(hud), m_text(text) {}
+
+    virtual void operator()(osg::Node* node, osg::NodeVisitor* nv)
+    {
+        bool changed = false;
+        for (unsigned int i = 0; i < m_text->numLabels(); ++i)
+        {
+            const OpenVRPoseHistory& history = m_device->poseHistory(i);
+            std::ostringstream readout;
+            readout << std::setw(2) << i << ": ";
+            if (history.empty())
+            {
+                readout << "-";
+            }
+            else
+            {
+                const osg::Vec3& position = history.latest().position;
+                readout << std::fixed << std::setprecision(2) << position.x() << " " << position.y() << " " << position.z();
+            }
+            changed |= m_text->setLabel(i, readout.str());
+        }
+        // The layer is only rendered again when a readout changed.
+        if (changed)
+        {
+            m_hud->setDirty();
+        }
+        traverse(node, nv);
+    }
+
+protected:
+    osg::ref_ptr<OpenVRDevice> m_device;
+    OSGHudVR* m_hud; // the node this callback is set on
+    osg::ref_ptr<OpenVRHudText> m_text;
 };
 
-int main( int argc, char** argv )
+// Opens the runtime and queries the device while the main thread creates the window.
+class DeviceInitThread : public OpenThreads::Thread
 {
-    // use an ArgumentParser object to manage the program arguments.
-    osg::ArgumentParser arguments(&argc, argv);
-    // read the scene from the list of file specified command line arguments.
-    osg::ref_ptr<osg::Node> loadedModel = osgDB::readNodeFiles(arguments);
+public:
+    DeviceInitThread(OpenVRBackend* backend, float nearClip, float farClip, float worldUnitsPerMetre, int samples, OpenVRStartupTimeline* timeline) :
+        m_backend(backend), m_nearClip(nearClip), m_farClip(farClip), m_worldUnitsPerMetre(worldUnitsPerMetre), m_samples(samples), m_timeline(timeline) {}
 
-    // if not loaded assume no arguments passed in, try use default cow model instead.
-    if (!loadedModel) { loadedModel = osgDB::readNodeFile("cow.osgt"); }
+    virtual void run()
+    {
+        unsigned int span = m_timeline->begin("VR runtime");
+        m_device = new OpenVRDevice(m_backend, m_nearClip, m_farClip, m_worldUnitsPerMetre, m_samples);
+        m_timeline->end(span);
 
-    // Still no loaded model, then exit
-    if (!loadedModel)
+        if (m_device->hmdInitialized())
+        {
+            span = m_timeline->begin("VR device");
+            m_device->init();
+            m_timeline->end(span);
+        }
+    }
+
+    // Valid once the thread has been joined.
+    osg::ref_ptr<OpenVRDevice> device() const { return m_device; }
+
+protected:
+    osg::ref_ptr<OpenVRBackend> m_backend;
+    float m_nearClip;
+    float m_farClip;
+    float m_worldUnitsPerMetre;
+    int m_samples;
+    osg::ref_ptr<OpenVRStartupTimeline> m_timeline;
+    osg::ref_ptr<OpenVRDevice> m_device;
+};
+
+// Wireframe box turning in front of the viewer while the scene is loading.
+static osg::Node* createPlaceholder()
+{
+    osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+    osg::ref_ptr<osg::ShapeDrawable> box = new osg::ShapeDrawable(new osg::Box(osg::Vec3(), 1.0f));
+    box->setColor(osg::Vec4(0.7f, 0.7f, 1.0f, 1.0f));
+    geode->addDrawable(box.get());
+    geode->getOrCreateStateSet()->setAttributeAndModes(new osg::PolygonMode(osg::PolygonMode::FRONT_AND_BACK, osg::PolygonMode::LINE));
+    geode->getOrCreateStateSet()->setMode(GL_LIGHTING, osg::StateAttribute::OFF);
+
+    osg::ref_ptr<osg::PositionAttitudeTransform> transform = new osg::PositionAttitudeTransform;
+    transform->setUpdateCallback(new osg::AnimationPathCallback(osg::Vec3(), osg::Z_AXIS, osg::PI_2));
+    transform->addChild(geode.get());
+    return transform.release();
+}
+
+// Renders a fixed number of frames as fast as the backend allows and prints a timing summary.
+static int runHeadless(osgViewer::Viewer& viewer, unsigned int frameCount)
+{
+    osg::Timer* timer = osg::Timer::instance();
+    std::vector<double> frameTimes;
+    frameTimes.reserve(frameCount);
+    double eyeGpuTotal = 0.0;
+    unsigned int eyeGpuFrames = 0;
+
+    const osg::Timer_t startTick = timer->tick();
+    while (!viewer.done() && frameTimes.size() < frameCount)
     {
-        osg::notify(osg::ALWAYS) << "No model could be loaded and didn't find cow.osgt, terminating.." << std::endl;
-        return 0;
+        const osg::Timer_t frameTick = timer->tick();
+        viewer.frame();
+        frameTimes.push_back(timer->delta_m(frameTick, timer->tick()));
+
+        // With a draw thread the frame just begun may still be drawing, the one before has finished.
+        double eyeGpu = 0.0;
+        const unsigned int frameNumber = viewer.getFrameStamp()->getFrameNumber();
+        if (frameNumber > 0 && viewer.getViewerStats()->getAttribute(frameNumber - 1, "OpenVR eye GPU", eyeGpu) && eyeGpu > 0.0)
+        {
+            eyeGpuTotal += eyeGpu;
+            ++eyeGpuFrames;
+        }
     }
+    const double totalSeconds = timer->delta_s(startTick, timer->tick());
 
-    // Create Trackball manipulator
-    osg::ref_ptr<osgGA::OrbitManipulator> cameraManipulator = new osgGA::OrbitManipulator;
-	cameraManipulator->setAllowThrow(false);
-	cameraManipulator->setAnimationTime(0);
+    if (frameTimes.empty())
+    {
+        osg::notify(osg::FATAL) << "Error: Headless run ended before rendering any frames." << std::endl;
+        return 1;
+    }
+
+    // The first frame is part of the startup timeline.
+    std::vector<double> sorted(frameTimes.begin(), frameTimes.end());
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for (double frameTime : sorted)
+    {
+        total += frameTime;
+    }
+
+    osg::notify(osg::ALWAYS) << "Headless run: " << frameTimes.size() << " frames in " << totalSeconds << " s ("
+                             << frameTimes.size() / totalSeconds << " fps)" << std::endl
+                             << "  frame mean " << total / sorted.size() << " ms, median " << sorted[sorted.size() / 2]
+                             << " ms, 99th percentile " << sorted[(sorted.size() * 99) / 100] << " ms, max " << sorted.back() << " ms" << std::endl;
+    if (eyeGpuFrames > 0)
+    {
+        osg::notify(osg::ALWAYS) << "  eye GPU mean " << eyeGpuTotal / eyeGpuFrames << " ms" << std::endl;
+    }
+    return 0;
+}
+
+int main( int argc, char** argv )
+{
+    osg::ref_ptr<OpenVRStartupTimeline> timeline = new OpenVRStartupTimeline;
 
-    const osg::BoundingSphere& bs = loadedModel->getBound();
+    // use an ArgumentParser object to manage the program arguments.
+    osg::ArgumentParser arguments(&argc, argv);
 
-    if (bs.valid())
+    // Use a scripted HMD instead of the OpenVR runtime, e.g. "--simulate 120" for a 120 Hz headset.
+    float simulatedRefreshRate = 90.0f;
+    bool simulate = arguments.read("--simulate", simulatedRefreshRate) || arguments.read("--simulate");
+    // Do not wait for the simulated vsync, render frames as fast as possible.
+    bool unpaced = arguments.read("--unpaced");
+    // Render the given number of frames into an offscreen pbuffer with the simulated HMD, then print the timing.
+    unsigned int headlessFrames = 600;
+    bool headless = arguments.read("--headless", headlessFrames) || arguments.read("--headless");
+    simulate = simulate || headless;
+    // Cull and draw the scene once for both eyes. Only triangles are drawn, lines and points are not,
+    // and the scene's shaders are replaced by one that lights like the fixed function pipeline.
+    bool singlePass = arguments.read("--single-pass");
+    // Cull once with the combined frustum of both eyes, draw each eye separately.
+    bool sharedCull = arguments.read("--shared-cull");
+    // Render both eyes side by side into one buffer, resolved and mirrored with one blit.
+    bool eyeAtlas = arguments.read("--atlas");
+    // Draw every lens pixel, also those hidden by the lens.
+    bool noHiddenAreaMask = arguments.read("--no-hidden-area-mask");
+    // Lower the eye resolution down to the given scale when the GPU time exceeds the frame budget.
+    float minResolutionScale = 0.6f;
+    bool dynamicResolution = arguments.read("--dynamic-resolution", minResolutionScale) || arguments.read("--dynamic-resolution");
+    // Resolve textures per eye, more let the next frame render while the compositor reads the last.
+    int resolveBuffers = 2;
+    arguments.read("--resolve-buffers", resolveBuffers);
+    // Desktop window content: off, left, right, both or compositor, updated every n-th frame.
+    std::string mirrorMode = headless ? "off" : "both";
+    arguments.read("--mirror", mirrorMode);
+    int mirrorInterval = 1;
+    arguments.read("--mirror-interval", mirrorInterval);
+    // Write the eye images of every n-th frame to a directory, as PNG or raw RGBA files.
+    std::string captureDirectory;
+    bool capture = arguments.read("--capture", captureDirectory);
+    bool captureRaw = arguments.read("--capture-raw");
+    unsigned int captureInterval = 1;
+    arguments.read("--capture-interval", captureInterval);
+    // Predict the head pose for the display of each frame, optionally that many ms further ahead.
+    float predictionOffsetMs = 0.0f;
+    bool predict = arguments.read("--predict", predictionOffsetMs) || arguments.read("--predict");
+    // Correct the eye views with the latest predicted pose right before each eye is drawn.
+    bool lateLatch = arguments.read("--late-latch");
+    // Show the controllers, their render models are converted once and cached in a directory.
+    bool noControllerModels = arguments.read("--no-controller-models");
+    std::string renderModelCache = "rendermodels";
+    arguments.read("--render-model-cache", renderModelCache);
+    // Show a head locked HUD panel, with a position readout of every tracked device slot instead of the text.
+    bool hud = arguments.read("--hud");
+    bool hudReadouts = arguments.read("--hud-readouts");
+
+    // GL objects of loaded models are compiled between frames, at least that many ms per frame.
+    double compileBudgetMs = 2.0;
+    arguments.read("--compile-budget", compileBudgetMs);
+    // Scene files are converted once into optimized .osgb files kept in a directory.
+    bool noSceneCache = arguments.read("--no-scene-cache");
+    std::string sceneCache = "scenecache";
+    arguments.read("--scene-cache", sceneCache);
+
+    // The viewer and osgDB consume their own options and values, e.g. "--window 0 0 800 600" or "-p path",
+    // so only scene files are left on the command line. The window is attached once it has been created.
+    GraphicsWindowViewer viewer(arguments, nullptr);
+
+    // The scene is read from the files given on the command line while the device and window are set up, the cow when there are none.
+    std::vector<std::string> fileNames;
+    for (int pos = 1; pos < arguments.argc(); ++pos)
     {
-        // Adjust view to object view
-      /* This caused a problem with the head tracking on the Vive
-        osg::Vec3 modelCenter = bs.center();
-        osg::Vec3 eyePos = bs.center() + osg::Vec3(0, bs.radius(), 0);
-        cameraManipulator->setHomePosition(eyePos, modelCenter, osg::Vec3(0, 0, 1));
-      */
+        if (!arguments.isOption(pos))
+        {
+            fileNames.push_back(arguments[pos]);
+        }
+    }
+    if (fileNames.empty())
+    {
+        fileNames.push_back("cow.osgt");
     }
+    osg::ref_ptr<OpenVRSceneLoader> sceneLoader = new OpenVRSceneLoader(fileNames, createPlaceholder());
+    sceneLoader->setStartupTimeline(timeline.get());
+    if (!noSceneCache)
+    {
+        sceneLoader->setSceneCache(new OpenVRSceneCache(sceneCache));
+    }
+    sceneLoader->start();
 
     // Exit if we do not have an HMD present
-    if (!OpenVRDevice::hmdPresent())
+    if (!simulate && !OpenVRDevice::hmdPresent())
     {
         osg::notify(osg::FATAL) << "Error: No valid HMD present!" << std::endl;
         return 1;
@@ -271,21 +323,32 @@ int main( int argc, char** argv )
     float farClip = 10000.0f;
     float worldUnitsPerMetre = 1.0f;
     int samples = 16;
-    osg::ref_ptr<OpenVRDevice> openvrDevice = new OpenVRDevice(nearClip, farClip, worldUnitsPerMetre, samples);
-
-    // Exit if we fail to initialize the HMD device
-    if (!openvrDevice->hmdInitialized())
+    osg::ref_ptr<OpenVRBackend> backend;
+    if (simulate)
     {
-        // The reason for failure was reported by the constructor.
-        return 1;
+        backend = new OpenVRSimulatedBackend(simulatedRefreshRate, !unpaced);
     }
+    DeviceInitThread deviceInit(backend.get(), nearClip, farClip, worldUnitsPerMetre, samples, timeline.get());
+    deviceInit.start();
 
     // Get the suggested context traits
-    osg::ref_ptr<osg::GraphicsContext::Traits> traits = openvrDevice->graphicsContextTraits();
+    const unsigned int contextSpan = timeline->begin("window and context");
+    osg::ref_ptr<osg::GraphicsContext::Traits> traits = OpenVRDevice::graphicsContextTraits(headless);
     traits->windowName = "OsgOpenVRViewerExample";
 
     // Create a graphic context based on our desired traits
     osg::ref_ptr<osg::GraphicsContext> gc = osg::GraphicsContext::createGraphicsContext(traits);
+    timeline->end(contextSpan);
+
+    deviceInit.join();
+    osg::ref_ptr<OpenVRDevice> openvrDevice = deviceInit.device();
+
+    // Exit if we fail to initialize the HMD device
+    if (!openvrDevice->hmdInitialized())
+    {
+        // The reason for failure was reported by the constructor.
+        return 1;
+    }
 
     if (!gc)
     {
@@ -293,16 +356,71 @@ int main( int argc, char** argv )
         return 1;
     }
 
-    if (gc.valid())
+    gc->setClearColor(osg::Vec4(0.2f, 0.2f, 0.4f, 1.0f));
+    gc->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (singlePass)
     {
-        gc->setClearColor(osg::Vec4(0.2f, 0.2f, 0.4f, 1.0f));
-        gc->setClearMask(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        openvrDevice->setStereoMode(OpenVRDevice::SINGLE_PASS);
+    }
+    else if (sharedCull)
+    {
+        openvrDevice->setStereoMode(OpenVRDevice::SHARED_CULL);
     }
 
-    GraphicsWindowViewer viewer(openvrDevice,arguments, dynamic_cast<osgViewer::GraphicsWindow*>(gc.get()));
+    openvrDevice->setEyeAtlas(eyeAtlas);
+    openvrDevice->setHiddenAreaMaskEnabled(!noHiddenAreaMask);
+    openvrDevice->setResolveBufferCount(resolveBuffers);
+    openvrDevice->setMirrorInterval(mirrorInterval);
+    openvrDevice->setPosePrediction(predict, predictionOffsetMs / 1000.0f);
+    openvrDevice->setLateLatch(lateLatch);
+
+    // Orbit manipulator moved by the controllers' touchpad and trigger
+    osg::ref_ptr<OpenVRManipulator> cameraManipulator = new OpenVRManipulator(openvrDevice.get());
+	cameraManipulator->setAllowThrow(false);
+	cameraManipulator->setAnimationTime(0);
+
+    if (capture)
+    {
+        osg::ref_ptr<OpenVRFrameCapture> frameCapture = new OpenVRFrameCapture(captureDirectory, captureRaw ? OpenVRFrameCapture::RAW : OpenVRFrameCapture::PNG);
+        frameCapture->setInterval(captureInterval);
+        openvrDevice->setFrameCapture(frameCapture.get());
+    }
+
+    if (mirrorMode == "off")
+    {
+        openvrDevice->setMirrorMode(OpenVRDevice::MIRROR_OFF);
+    }
+    else if (mirrorMode == "left")
+    {
+        openvrDevice->setMirrorMode(OpenVRDevice::MIRROR_LEFT);
+    }
+    else if (mirrorMode == "right")
+    {
+        openvrDevice->setMirrorMode(OpenVRDevice::MIRROR_RIGHT);
+    }
+    else if (mirrorMode == "compositor")
+    {
+        openvrDevice->setMirrorMode(OpenVRDevice::MIRROR_COMPOSITOR);
+    }
+    else if (mirrorMode != "both")
+    {
+        osg::notify(osg::WARN) << "Warning: Unknown mirror mode \"" << mirrorMode << "\", mirroring both eyes." << std::endl;
+    }
 
-    // Force single threaded to make sure that no other thread can use the GL context
-    viewer.setThreadingModel(osgViewer::Viewer::SingleThreaded);
+    if (dynamicResolution)
+    {
+        openvrDevice->setResolutionGovernor(new OpenVRResolutionGovernor(minResolutionScale, 1.0f));
+    }
+
+    viewer.setGraphicsWindow(dynamic_cast<osgViewer::GraphicsWindow*>(gc.get()));
+
+    // Draw in its own thread while the next frame is updated and culled, unless a
+    // threading model was chosen on the command line, e.g. --SingleThreaded.
+    if (viewer.getThreadingModel() == osgViewer::ViewerBase::AutomaticSelection)
+    {
+        viewer.setThreadingModel(osgViewer::Viewer::DrawThreadPerContext);
+    }
     viewer.getCamera()->setGraphicsContext(gc);
     viewer.getCamera()->setViewport(0, 0, traits->width, traits->height);
 
@@ -316,17 +434,118 @@ int main( int argc, char** argv )
 
     osg::ref_ptr<OpenVRViewer> openvrViewer = new OpenVRViewer(&viewer, openvrDevice, openvrRealizeOperation);
 
-    openvrViewer->addChild(loadedModel);
+    // Models are compiled between frames before they are shown.
+    osg::ref_ptr<osgUtil::IncrementalCompileOperation> incrementalCompile = new osgUtil::IncrementalCompileOperation;
+    incrementalCompile->setTargetFrameRate(openvrDevice->backend()->displayFrequency());
+    incrementalCompile->setMinimumTimeAvailableForGLCompileAndDeletePerFrame(compileBudgetMs / 1000.0);
+    viewer.setIncrementalCompileOperation(incrementalCompile.get());
+
+    sceneLoader->setIncrementalCompileOperation(incrementalCompile.get());
+    sceneLoader->setManipulator(cameraManipulator.get());
+    openvrViewer->addChild(sceneLoader);
+
+    osg::ref_ptr<OpenVRRenderModelLoader> renderModelLoader;
+    if (!noControllerModels)
+    {
+        renderModelLoader = new OpenVRRenderModelLoader(openvrDevice->backend(), renderModelCache);
+        osg::ref_ptr<OpenVRControllerModels> controllerModels = new OpenVRControllerModels(openvrDevice.get(), renderModelLoader.get(), viewer.getCamera());
+        controllerModels->setIncrementalCompileOperation(viewer.getIncrementalCompileOperation());
+        openvrViewer->addChild(controllerModels);
+    }
+    if (hud || hudReadouts)
+    {
+        osg::ref_ptr<OSGHudVR> hudPanel = new OSGHudVR(openvrDevice.get(), viewer.getCamera());
+        if (hudReadouts)
+        {
+            // All readouts are labels of one drawable, four columns of device slots.
+            const unsigned int rows = vr::k_unMaxTrackedDeviceCount / 4;
+            const float characterSize = hudPanel->layerHeight() / (rows * 1.5f);
+            osg::ref_ptr<OpenVRHudText> readouts = new OpenVRHudText("fonts/arial.ttf", characterSize);
+            for (unsigned int i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+            {
+                readouts->addLabel(osg::Vec2((i / rows) * hudPanel->layerWidth() / 4.0f,
+                                             hudPanel->layerHeight() - ((i % rows) + 1) * characterSize * 1.4f), "");
+            }
+            osg::ref_ptr<osg::Geode> geode = new osg::Geode;
+            geode->addDrawable(readouts.get());
+            hudPanel->content()->addChild(geode.get());
+            hudPanel->setUpdateCallback(new HudReadoutCallback(openvrDevice.get(), hudPanel.get(), readouts.get()));
+        }
+        else
+        {
+            hudPanel->content()->addChild(OSGHudVR::createHud(hudPanel->layerWidth(), hudPanel->layerHeight()));
+        }
+        openvrViewer->addChild(hudPanel);
+    }
     viewer.setSceneData(openvrViewer);
-    // Add statistics handler
-    viewer.addEventHandler(new osgViewer::StatsHandler);
+    // Add statistics handler, including the frame timing reported by the compositor
+    openvrDevice->setStats(viewer.getViewerStats());
+    viewer.getViewerStats()->collectStats("openvr", true);
+
+    osg::ref_ptr<osgViewer::StatsHandler> statsHandler = new osgViewer::StatsHandler;
+    statsHandler->addUserStatsLine("VR interval", osg::Vec4(0.7f, 0.7f, 1.0f, 1.0f), osg::Vec4(0.7f, 0.7f, 1.0f, 0.5f),
+                                   "OpenVR frame interval", 1.0, true, false, "", "", 22.2);
+    statsHandler->addUserStatsLine("VR submit", osg::Vec4(1.0f, 0.7f, 0.7f, 1.0f), osg::Vec4(1.0f, 0.7f, 0.7f, 0.5f),
+                                   "OpenVR submit", 1.0, true, false, "", "", 22.2);
+    statsHandler->addUserStatsLine("VR hidden %", osg::Vec4(0.7f, 1.0f, 0.7f, 1.0f), osg::Vec4(0.7f, 1.0f, 0.7f, 0.5f),
+                                   "OpenVR hidden area masked", 1.0, false, false, "", "", 100.0);
+    statsHandler->addUserStatsLine("VR eye GPU", osg::Vec4(1.0f, 1.0f, 0.7f, 1.0f), osg::Vec4(1.0f, 1.0f, 0.7f, 0.5f),
+                                   "OpenVR eye GPU", 1.0, true, false, "", "", 22.2);
+    statsHandler->addUserStatsLine("VR res scale", osg::Vec4(1.0f, 1.0f, 0.7f, 1.0f), osg::Vec4(1.0f, 1.0f, 0.7f, 0.5f),
+                                   "OpenVR resolution scale", 1.0, false, false, "", "", 1.0);
+    statsHandler->addUserStatsLine("VR resolve stall", osg::Vec4(1.0f, 0.7f, 0.7f, 1.0f), osg::Vec4(1.0f, 0.7f, 0.7f, 0.5f),
+                                   "OpenVR resolve stall", 1.0, true, false, "", "", 11.1);
+    statsHandler->addUserStatsLine("VR capture queue", osg::Vec4(0.7f, 1.0f, 1.0f, 1.0f), osg::Vec4(0.7f, 1.0f, 1.0f, 0.5f),
+                                   "OpenVR capture queue", 1.0, true, false, "", "", 8.0);
+    statsHandler->addUserStatsLine("VR capture dropped", osg::Vec4(1.0f, 0.7f, 0.7f, 1.0f), osg::Vec4(1.0f, 0.7f, 0.7f, 0.5f),
+                                   "OpenVR capture dropped", 1.0, true, false, "", "", 100.0);
+    statsHandler->addUserStatsLine("VR GL calls", osg::Vec4(0.7f, 0.7f, 1.0f, 1.0f), osg::Vec4(0.7f, 0.7f, 1.0f, 0.5f),
+                                   "OpenVR GL calls", 1.0, true, false, "", "", 100.0);
+    statsHandler->addUserStatsLine("VR pose error mm", osg::Vec4(1.0f, 0.7f, 1.0f, 1.0f), osg::Vec4(1.0f, 0.7f, 1.0f, 0.5f),
+                                   "OpenVR pose error", 1.0, true, false, "", "", 20.0);
+    statsHandler->addUserStatsLine("VR pose error deg", osg::Vec4(1.0f, 0.7f, 1.0f, 1.0f), osg::Vec4(1.0f, 0.7f, 1.0f, 0.5f),
+                                   "OpenVR pose error angle", 1.0, true, false, "", "", 5.0);
+    viewer.addEventHandler(statsHandler);
 
     viewer.addEventHandler(new OpenVREventHandler(openvrDevice));
 
-    viewer.run();
+    // Startup ends with the first frame, the eye buffers are created when the viewer is realized.
+    const unsigned int realizeSpan = timeline->begin("realize");
+    viewer.realize();
+    timeline->end(realizeSpan);
+    if (!viewer.isRealized())
+    {
+        osg::notify(osg::FATAL) << "Error: Viewer could not be realized." << std::endl;
+        return 1;
+    }
+    const unsigned int frameSpan = timeline->begin("first frame");
+    viewer.frame();
+    timeline->end(frameSpan);
+    timeline->print(osg::notify(osg::NOTICE));
+
+    int result = headless ? runHeadless(viewer, headlessFrames) : viewer.run();
+
+    sceneLoader->stop();
+
+    // The loader may be waiting for the runtime, it has to finish before the runtime is shut down.
+    if (renderModelLoader.valid())
+    {
+        renderModelLoader->stop();
+    }
 
     // Need to do this here to make it happen before destruction of the OSG Viewer, which destroys the OpenGL context.
+    // The draw thread owns the context until it is stopped, the GL objects are deleted on this thread.
+    viewer.stopThreading();
+    gc->makeCurrent();
     openvrDevice->shutdown(gc.get());
+    gc->releaseContext();
 
-    return 0;
+    if (capture)
+    {
+        OpenVRFrameCapture* frameCapture = openvrDevice->frameCapture();
+        osg::notify(osg::NOTICE) << "Captured " << frameCapture->capturedFrames() << " frames, wrote " << frameCapture->writtenFrames()
+                                 << ", dropped " << frameCapture->droppedFrames() << std::endl;
+    }
+
+    return result;
 }